@@ -0,0 +1,197 @@
+// Live analysis - a background search that scores every legal move of a position
+#ifndef OTHELLO_ANALYSIS_H
+#define OTHELLO_ANALYSIS_H
+
+#include "search.h"
+#include <algorithm>    // For stable_sort
+#include <atomic>       // For cancelling the search
+#include <condition_variable>
+#include <memory>       // For the lazily created table and search thread
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const size_t ANALYSIS_TT_SIZE_MB = 32;  // Table of the analysis search, separate from the AI's
+const int ANALYSIS_SOLVE_EMPTIES = 14;  // Moves are solved exactly from this many empties on
+
+// Score of one legal move after the search so far
+struct MoveAnalysis {
+    int move = NO_MOVE;
+    int score = 0;          // For the side to move in the analysed position
+    int depth = 0;          // Plies searched, the move included; 0 = not searched yet
+    bool exact = false;     // Score is the final disc differential
+};
+
+// Scores every legal move by searching each one on its own, one ply deeper per
+// round, on a single background thread. The render loop hands it the current
+// position every frame (a no-op unless the position changed) and copies the
+// results only when Version() says they changed. A new position cancels the
+// running search; the transposition table is kept, so positions reached again
+// (after the move that was just analysed, say) start from what is known.
+class LiveAnalysis {
+    private:
+        std::unique_ptr<TranspositionTable> tt;     // Created with the thread on first use
+        SearchShared shared;
+        std::unique_ptr<SearchThread> search;
+        std::thread worker;
+
+        mutable std::mutex mutex;
+        std::condition_variable wake;           // New position or shutting down
+        std::atomic<bool> cancelled{false};     // Abandon the running search
+        Position position;                      // Position to analyse
+        uint64_t generation = 0;                // Bumped for every new position
+        bool active = false;                    // A position was given and not withdrawn
+        bool finished = false;                  // Every move of it is solved or maximally deep
+        bool quitting = false;
+        std::vector<MoveAnalysis> results;
+        uint64_t version = 0;                   // Bumped whenever results change
+
+        // Score of move in pos searched to depth plies (the move included)
+        MoveAnalysis SearchMove(const Position& pos, int move, int depth) {
+            MoveAnalysis a;
+            a.move = move;
+            a.depth = depth;
+            Position child = pos;
+            child.MakeMove(move);
+            if (child.IsGameOver()) {
+                int diff = PopCount(child.bits.Discs(pos.currentPlayer)) - PopCount(child.bits.Discs(child.currentPlayer));
+                a.score = diff > 0 ? WIN_SCORE + diff : diff < 0 ? -WIN_SCORE + diff : 0;
+                a.exact = true;
+                return a;
+            }
+            bool passed = child.LegalMoves() == 0;  // The reply is forced: pass back
+            if (passed) child.Pass();
+
+            int empties = PopCount(child.bits.Empty());
+            shared.maxDepth = depth - 1;
+            shared.start = Clock::now();
+            shared.deadline = shared.start + std::chrono::hours(24);   // Only cancelled, never timed out
+            shared.stop = false;
+            search->Run(child, 0, ANALYSIS_SOLVE_EMPTIES);
+            a.score = passed ? search->bestRootScore : -search->bestRootScore;
+            a.exact = empties <= ANALYSIS_SOLVE_EMPTIES;   // Run solved it
+            return a;
+        }
+
+        // Deepen every move of pos until all are exact, or until cancelled
+        void Analyse(const Position& pos, uint64_t gen) {
+            std::vector<MoveAnalysis> scores;
+            for (uint64_t moves = pos.LegalMoves(); moves; moves &= moves - 1) {
+                MoveAnalysis a;
+                a.move = LowestBit(moves);
+                scores.push_back(a);
+            }
+            tt->NewSearch();
+
+            int empties = PopCount(pos.bits.Empty());
+            for (int depth = 2; depth <= std::min(empties, MAX_PLY - 1); depth++) {
+                // Best moves first, so the likely choices firm up soonest
+                std::stable_sort(scores.begin(), scores.end(),
+                    [](const MoveAnalysis& a, const MoveAnalysis& b) { return a.score > b.score; });
+                bool allExact = true;
+                for (MoveAnalysis& a : scores) {
+                    if (a.exact) continue;
+                    MoveAnalysis result = SearchMove(pos, a.move, depth);
+                    if (cancelled) return;
+                    a = result;
+                    allExact &= a.exact;
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (gen != generation) return;
+                    for (MoveAnalysis& r : results)
+                        if (r.move == a.move) r = a;
+                    version++;
+                }
+                if (allExact) break;
+            }
+        }
+
+        void WorkerLoop() {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;) {
+                wake.wait(lock, [this]() { return quitting || (active && !finished); });
+                if (quitting) return;
+                Position pos = position;
+                uint64_t gen = generation;
+                cancelled = false;
+                lock.unlock();
+                Analyse(pos, gen);
+                lock.lock();
+                if (gen == generation) finished = true;
+            }
+        }
+
+    public:
+        LiveAnalysis() {}
+
+        ~LiveAnalysis() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quitting = true;
+                cancelled = true;
+            }
+            wake.notify_all();
+            if (worker.joinable()) worker.join();
+        }
+
+        LiveAnalysis(const LiveAnalysis&) = delete;
+        LiveAnalysis& operator=(const LiveAnalysis&) = delete;
+
+        // Analyse pos from now on; cheap when pos is the position already being analysed
+        void SetPosition(const Position& pos) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (active && pos.hash == position.hash) return;
+                if (!worker.joinable()) {
+                    tt.reset(new TranspositionTable(ANALYSIS_TT_SIZE_MB));
+                    shared.tt = tt.get();
+                    shared.cancelled = &cancelled;
+                    search.reset(new SearchThread(shared, true));
+                    worker = std::thread([this]() { WorkerLoop(); });
+                }
+                position = pos;
+                generation++;
+                active = true;
+                finished = false;
+                cancelled = true;
+                results.clear();
+                for (uint64_t moves = pos.LegalMoves(); moves; moves &= moves - 1) {
+                    MoveAnalysis a;
+                    a.move = LowestBit(moves);
+                    results.push_back(a);
+                }
+                version++;
+            }
+            wake.notify_all();
+        }
+
+        // Stop analysing (the results are dropped)
+        void Stop() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!active) return;
+            active = false;
+            cancelled = true;
+            results.clear();
+            version++;
+        }
+
+        // Searching, i.e. the results may still change
+        bool Running() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return active && !finished;
+        }
+
+        uint64_t Version() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return version;
+        }
+
+        // Copy of the current results, one per legal move in square order
+        std::vector<MoveAnalysis> Results(uint64_t* resultsVersion = nullptr) const {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (resultsVersion) *resultsVersion = version;
+            return results;
+        }
+};
+
+#endif
@@ -0,0 +1,54 @@
+// Bitboard primitives - board geometry and disc masks
+#ifndef OTHELLO_BITBOARD_H
+#define OTHELLO_BITBOARD_H
+
+#include "move_kernels.h"   // For GetMoves and GetFlips
+#include <cstdint>      // For 64-bit bitboard masks
+
+const int BOARD_SIZE = 8;       // 8x8 Othello board
+
+enum Cell { EMPTY, Black_Disc, White_Disc };    // Possible cell states
+
+inline int PopCount(uint64_t b) { return __builtin_popcountll(b); }
+inline int LowestBit(uint64_t b) { return __builtin_ctzll(b); }
+inline uint64_t SquareBit(int row, int col) { return 1ULL << (row * BOARD_SIZE + col); }
+
+// Bitboard position - black and white disc masks
+struct BitBoard {
+    uint64_t black = 0;
+    uint64_t white = 0;
+
+    uint64_t Discs(Cell player) const { return player == Black_Disc ? black : white; }
+    uint64_t Empty() const { return ~(black | white); }
+
+    Cell At(int row, int col) const {
+        uint64_t bit = SquareBit(row, col);
+        return (black & bit) ? Black_Disc : (white & bit) ? White_Disc : EMPTY;
+    }
+
+    uint64_t LegalMoves(Cell player) const {
+        return player == Black_Disc ? GetMoves(black, white) : GetMoves(white, black);
+    }
+
+    uint64_t Flips(Cell player, int sq) const {
+        return player == Black_Disc ? GetFlips(black, white, sq) : GetFlips(white, black, sq);
+    }
+
+    // Place a disc for player on sq and flip the given discs
+    void Apply(Cell player, int sq, uint64_t flips) {
+        uint64_t placed = (1ULL << sq) | flips;
+        if (player == Black_Disc) { black |= placed; white &= ~flips; }
+        else                      { white |= placed; black &= ~flips; }
+    }
+
+    // Take back a disc placed by player on sq together with its flips
+    void Revert(Cell player, int sq, uint64_t flips) {
+        uint64_t placed = (1ULL << sq) | flips;
+        if (player == Black_Disc) { black &= ~placed; white |= flips; }
+        else                      { white &= ~placed; black |= flips; }
+    }
+};
+
+inline Cell Opponent(Cell player) { return player == Black_Disc ? White_Disc : Black_Disc; }
+
+#endif
@@ -0,0 +1,105 @@
+// Opening book - best moves for known positions in a sorted, memory-mapped file
+#ifndef OTHELLO_BOOK_H
+#define OTHELLO_BOOK_H
+
+#include "mapped_file.h"
+#include "symmetry.h"
+#include <algorithm>    // For sort and lower_bound
+#include <cstring>      // For the file header
+#include <fstream>      // For writing books
+#include <stdexcept>    // For book file errors
+#include <string>
+#include <vector>
+
+// File layout: 16-byte header (magic, entry size, entry count), then entries
+// sorted by key. Nothing is parsed on open, so many engine processes can share
+// one book through the page cache.
+const char BOOK_MAGIC[8] = {'O', 'T', 'H', 'B', 'O', 'O', 'K', '2'};
+
+struct BookHeader {
+    char magic[8];
+    uint32_t entrySize;
+    uint32_t count;
+};
+
+// One position, keyed by its canonical key (see symmetry.h); the move
+// is stored in the canonical orientation
+struct BookEntry {
+    uint64_t key;
+    int32_t score;          // Search score for the side to move
+    uint8_t move;
+    uint8_t depth;          // Depth the position was searched to
+    uint16_t reserved;
+};
+static_assert(sizeof(BookEntry) == 16, "BookEntry must stay 16 bytes");
+
+class OpeningBook {
+    private:
+        MappedFile file;
+        const BookEntry* entries = nullptr;
+        size_t count = 0;
+
+    public:
+        OpeningBook() {}
+
+        explicit OpeningBook(const std::string& path) {
+            Open(path);
+        }
+
+        // Throws if the file is missing or is not a book
+        void Open(const std::string& path) {
+            file.Open(path);
+            BookHeader header;
+            if (file.Size() < sizeof header) throw std::runtime_error(path + " is not a book");
+            std::memcpy(&header, file.Data(), sizeof header);
+            if (std::memcmp(header.magic, BOOK_MAGIC, sizeof header.magic) != 0 || header.entrySize != sizeof(BookEntry))
+                throw std::runtime_error(path + " is not a book");
+            if (file.Size() < sizeof header + (size_t)header.count * sizeof(BookEntry))
+                throw std::runtime_error(path + " is truncated");
+            entries = reinterpret_cast<const BookEntry*>(file.Data() + sizeof header);
+            count = header.count;
+        }
+
+        bool IsOpen() const { return entries != nullptr; }
+        size_t Size() const { return count; }
+        const BookEntry* begin() const { return entries; }
+        const BookEntry* end() const { return entries + count; }
+
+        // Entry for a canonical key
+        const BookEntry* Find(uint64_t key) const {
+            const BookEntry* e = std::lower_bound(begin(), end(), key,
+                [](const BookEntry& entry, uint64_t k) { return entry.key < k; });
+            return (e != end() && e->key == key) ? e : nullptr;
+        }
+
+        // Book move for pos in its own orientation, or -1 when pos is not in the book
+        int Probe(const Position& pos, int* score = nullptr) const {
+            if (!entries) return -1;
+            int s;
+            const BookEntry* e = Find(CanonicalKey(pos, s));
+            if (!e || e->move >= 64) return -1;
+            int move = TransformSquare(e->move, InverseSymmetry(s));
+            if (!(pos.LegalMoves() & (1ULL << move))) return -1;    // Key collision
+            if (score) *score = e->score;
+            return move;
+        }
+};
+
+// Sort entries by key (dropping repeated keys) and write them as a book
+inline void WriteBook(const std::string& path, std::vector<BookEntry> entries) {
+    std::sort(entries.begin(), entries.end(), [](const BookEntry& a, const BookEntry& b) { return a.key < b.key; });
+    entries.erase(std::unique(entries.begin(), entries.end(),
+        [](const BookEntry& a, const BookEntry& b) { return a.key == b.key; }), entries.end());
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out) throw std::runtime_error("Failed to open " + path + " for writing");
+    BookHeader header;
+    std::memcpy(header.magic, BOOK_MAGIC, sizeof header.magic);
+    header.entrySize = sizeof(BookEntry);
+    header.count = (uint32_t)entries.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof header);
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(BookEntry));
+    if (!out) throw std::runtime_error("Failed to write " + path);
+}
+
+#endif
@@ -0,0 +1,398 @@
+// Position evaluation - edge, corner, line and diagonal patterns plus mobility,
+// potential mobility and stability, updated incrementally as moves are made
+#ifndef OTHELLO_EVAL_H
+#define OTHELLO_EVAL_H
+
+#include "position.h"
+#include <cstdint>
+#include <algorithm>    // For min, max and swap
+#include <vector>       // For the weight tables
+#include <cstring>      // For the weight file header
+#include <fstream>      // For loading and saving weights
+#include <stdexcept>    // For weight file errors
+#include <string>
+
+const int EVAL_PHASES = 12;             // Weight sets by number of empty squares (5 per phase)
+const int EVAL_PATTERN_TYPES = 11;
+const int EVAL_PATTERNS = 46;           // Pattern instances on the board (all symmetries)
+const int EVAL_PATTERN_SLOTS = 48;      // Padded to a multiple of 8 for the vector sum
+const int EVAL_FEATURES = 3;            // Mobility, potential mobility, stability
+const int EVAL_MOVE_GENS = 2;           // Move generations per Score (mobility of both sides)
+const int EVAL_MAX_SCORE = 30000;       // Heuristic scores are clamped to this (below WIN_SCORE)
+const int EVAL_DISC = 100;              // Trained weights score one disc of final margin as this
+const char EVAL_WEIGHTS_MAGIC[8] = {'O', 'T', 'H', 'E', 'V', 'A', 'L', '1'};
+
+// Static square values: prioritize corners and discourage the squares next to them
+const int SQUARE_WEIGHT[8][8] = {
+    {100, -20, 10, 5, 5, 10, -20, 100},
+    {-20, -50, -2, -2, -2, -2, -50, -20},
+    {10, -2, 0, 0, 0, 0, -2, 10},
+    {5, -2, 0, 0, 0, 0, -2, 5},
+    {5, -2, 0, 0, 0, 0, -2, 5},
+    {10, -2, 0, 0, 0, 0, -2, 10},
+    {-20, -50, -2, -2, -2, -2, -50, -20},
+    {100, -20, 10, 5, 5, 10, -20, 100}
+};
+
+enum EvalFeature { FEATURE_MOBILITY, FEATURE_POTENTIAL_MOBILITY, FEATURE_STABILITY };
+
+inline int EvalPhase(int empties) {
+    int phase = empties / 5;
+    return phase < EVAL_PHASES ? phase : EVAL_PHASES - 1;
+}
+
+// Pattern geometry: every type is given once in one orientation as (row, col)
+// pairs and expanded to all distinct symmetric copies. A pattern's code is the
+// base-3 number of its squares (0 empty, 1 black, 2 white), first square lowest.
+class PatternSet {
+    public:
+        struct Type {
+            const char* name;
+            int size;                   // Squares per instance
+            int squares[10][2];         // (row, col) in the base orientation
+        };
+
+        int instanceType[EVAL_PATTERNS];            // Type of each instance
+        int instanceSquares[EVAL_PATTERNS][10];     // Board squares, in code order
+        uint32_t typeOffset[EVAL_PATTERN_TYPES];    // Start of each type's weights in a phase table
+        uint32_t typeSize[EVAL_PATTERN_TYPES];      // 3^size
+        uint32_t phaseSize = 0;         // Weights per phase, plus one zero entry for the padding slots
+        uint32_t zeroIndex = 0;         // Always-zero entry the padding slots point at
+        int squareRefCount[64];         // Instances touching each square
+        uint16_t squarePower[64][EVAL_PATTERN_SLOTS];   // 3^k in every instance containing the square, else 0
+        uint32_t slotOffset[EVAL_PATTERN_SLOTS];        // Start of each instance's weights in a phase table
+
+        static const Type* Types() {
+            static const Type TYPES[EVAL_PATTERN_TYPES] = {
+                {"edge+2x", 10, {{0,0},{0,1},{0,2},{0,3},{0,4},{0,5},{0,6},{0,7},{1,1},{1,6}}},
+                {"corner3x3", 9, {{0,0},{0,1},{0,2},{1,0},{1,1},{1,2},{2,0},{2,1},{2,2}}},
+                {"corner2x5", 10, {{0,0},{0,1},{0,2},{0,3},{0,4},{1,0},{1,1},{1,2},{1,3},{1,4}}},
+                {"line2", 8, {{1,0},{1,1},{1,2},{1,3},{1,4},{1,5},{1,6},{1,7}}},
+                {"line3", 8, {{2,0},{2,1},{2,2},{2,3},{2,4},{2,5},{2,6},{2,7}}},
+                {"line4", 8, {{3,0},{3,1},{3,2},{3,3},{3,4},{3,5},{3,6},{3,7}}},
+                {"diag8", 8, {{0,0},{1,1},{2,2},{3,3},{4,4},{5,5},{6,6},{7,7}}},
+                {"diag7", 7, {{0,1},{1,2},{2,3},{3,4},{4,5},{5,6},{6,7}}},
+                {"diag6", 6, {{0,2},{1,3},{2,4},{3,5},{4,6},{5,7}}},
+                {"diag5", 5, {{0,3},{1,4},{2,5},{3,6},{4,7}}},
+                {"diag4", 4, {{0,4},{1,5},{2,6},{3,7}}},
+            };
+            return TYPES;
+        }
+
+        // Built once on first use
+        static const PatternSet& Get() {
+            static const PatternSet set;
+            return set;
+        }
+
+    private:
+        PatternSet() {
+            const Type* types = Types();
+            int count = 0;
+            for (int t = 0; t < EVAL_PATTERN_TYPES; t++) {
+                typeSize[t] = 1;
+                for (int i = 0; i < types[t].size; i++) typeSize[t] *= 3;
+                typeOffset[t] = phaseSize;
+                phaseSize += typeSize[t];
+
+                // The 8 board symmetries; copies covering the same squares are dropped
+                uint64_t seen[8];
+                int seenCount = 0;
+                for (int s = 0; s < 8; s++) {
+                    int squares[10];
+                    uint64_t mask = 0;
+                    for (int i = 0; i < types[t].size; i++) {
+                        int r = types[t].squares[i][0], c = types[t].squares[i][1];
+                        if (s & 1) c = 7 - c;
+                        if (s & 2) r = 7 - r;
+                        if (s & 4) std::swap(r, c);
+                        squares[i] = r * BOARD_SIZE + c;
+                        mask |= 1ULL << squares[i];
+                    }
+                    bool duplicate = false;
+                    for (int k = 0; k < seenCount; k++) duplicate |= seen[k] == mask;
+                    if (duplicate) continue;
+                    seen[seenCount++] = mask;
+
+                    instanceType[count] = t;
+                    for (int i = 0; i < types[t].size; i++) instanceSquares[count][i] = squares[i];
+                    count++;
+                }
+            }
+            zeroIndex = phaseSize;
+            phaseSize += 8;             // Zero entry plus slack for the 32-bit gathers
+
+            for (int sq = 0; sq < 64; sq++) {
+                squareRefCount[sq] = 0;
+                for (uint16_t& p : squarePower[sq]) p = 0;
+            }
+            for (int n = 0; n < EVAL_PATTERN_SLOTS; n++)
+                slotOffset[n] = n < EVAL_PATTERNS ? typeOffset[instanceType[n]] : zeroIndex;
+            for (int n = 0; n < EVAL_PATTERNS; n++) {
+                uint16_t power = 1;
+                for (int i = 0; i < types[instanceType[n]].size; i++, power *= 3) {
+                    int sq = instanceSquares[n][i];
+                    squareRefCount[sq]++;
+                    squarePower[sq][n] = power;
+                }
+            }
+        }
+};
+
+// Weight tables for every phase: pattern scores from Black's point of view and
+// weights per unit of each feature
+class EvalWeights {
+    public:
+        size_t phaseSize;                           // PatternSet::phaseSize
+        std::vector<int16_t> patterns;              // EVAL_PHASES x phaseSize
+        int16_t features[EVAL_PHASES][EVAL_FEATURES];
+
+        EvalWeights() : phaseSize(PatternSet::Get().phaseSize), patterns(EVAL_PHASES * phaseSize, 0) {
+            for (auto& phase : features)
+                for (int16_t& w : phase) w = 0;
+        }
+
+        const int16_t* Phase(int phase) const {
+            return &patterns[phase * phaseSize];
+        }
+
+        int16_t* Phase(int phase) {
+            return &patterns[phase * phaseSize];
+        }
+
+        // Hand-made starting weights: every pattern scores its squares by the classic
+        // square weight table (shared evenly between the patterns covering a square),
+        // plus fixed mobility and stability terms
+        static EvalWeights Default() {
+            const PatternSet& set = PatternSet::Get();
+            const PatternSet::Type* types = PatternSet::Types();
+            EvalWeights w;
+
+            // Table entries for one type are built from its first instance
+            int firstInstance[EVAL_PATTERN_TYPES];
+            for (int n = EVAL_PATTERNS - 1; n >= 0; n--) firstInstance[set.instanceType[n]] = n;
+
+            for (int t = 0; t < EVAL_PATTERN_TYPES; t++) {
+                const int* squares = set.instanceSquares[firstInstance[t]];
+                for (uint32_t code = 0; code < set.typeSize[t]; code++) {
+                    int score = 0;
+                    uint32_t c = code;
+                    for (int i = 0; i < types[t].size; i++, c /= 3) {
+                        int sq = squares[i];
+                        int value = SQUARE_WEIGHT[sq / BOARD_SIZE][sq % BOARD_SIZE] * 4 / set.squareRefCount[sq];
+                        if (c % 3 == 1) score += value;
+                        else if (c % 3 == 2) score -= value;
+                    }
+                    for (int phase = 0; phase < EVAL_PHASES; phase++)
+                        w.Phase(phase)[set.typeOffset[t] + code] = (int16_t)score;
+                }
+            }
+            for (int phase = 0; phase < EVAL_PHASES; phase++) {
+                w.features[phase][FEATURE_MOBILITY] = 24;
+                w.features[phase][FEATURE_POTENTIAL_MOBILITY] = 4;
+                w.features[phase][FEATURE_STABILITY] = 64;
+            }
+            return w;
+        }
+
+        // Weight file: "OTHEVAL1", u32 phases, u32 phase size, u32 features, then the
+        // pattern weights and the feature weights as little-endian int16
+        void Save(const std::string& path) const {
+            std::ofstream out(path, std::ios::binary);
+            if (!out) throw std::runtime_error("Failed to open " + path + " for writing");
+            uint32_t header[3] = {EVAL_PHASES, (uint32_t)phaseSize, EVAL_FEATURES};
+            out.write(EVAL_WEIGHTS_MAGIC, 8);
+            out.write(reinterpret_cast<const char*>(header), sizeof header);
+            out.write(reinterpret_cast<const char*>(patterns.data()), patterns.size() * sizeof(int16_t));
+            out.write(reinterpret_cast<const char*>(features), sizeof features);
+            if (!out) throw std::runtime_error("Failed to write " + path);
+        }
+
+        // Throws if the file is missing or was trained for a different pattern set
+        static EvalWeights Load(const std::string& path) {
+            std::ifstream in(path, std::ios::binary);
+            if (!in) throw std::runtime_error("Failed to open " + path);
+            EvalWeights w;
+            char magic[8];
+            uint32_t header[3];
+            in.read(magic, 8);
+            in.read(reinterpret_cast<char*>(header), sizeof header);
+            if (!in || std::memcmp(magic, EVAL_WEIGHTS_MAGIC, 8) != 0)
+                throw std::runtime_error(path + " is not a weight file");
+            if (header[0] != EVAL_PHASES || header[1] != w.phaseSize || header[2] != EVAL_FEATURES)
+                throw std::runtime_error(path + " does not match this evaluator's patterns");
+            in.read(reinterpret_cast<char*>(w.patterns.data()), w.patterns.size() * sizeof(int16_t));
+            in.read(reinterpret_cast<char*>(w.features), sizeof w.features);
+            if (!in) throw std::runtime_error(path + " is truncated");
+            return w;
+        }
+
+        // Weights used by every search; set once at startup
+        static EvalWeights& Active() {
+            static EvalWeights weights = Default();
+            return weights;
+        }
+};
+
+// Stable discs of P on the edges: runs anchored on an owned corner, and every
+// disc of a completely filled edge. Interior stability is rare and not counted.
+inline uint64_t StableDiscs(uint64_t P, uint64_t O) {
+    const uint64_t FILE_A = 0x0101010101010101ULL, FILE_H = 0x8080808080808080ULL;
+    const uint64_t RANK_1 = 0x00000000000000FFULL, RANK_8 = 0xFF00000000000000ULL;
+    const uint64_t CORNERS = 0x8100000000000081ULL;
+    if (((P | O) & CORNERS) == 0) return 0;     // Nothing is stable before a corner is taken
+    uint64_t stable = P & CORNERS;
+
+    uint64_t ranks = P & (RANK_1 | RANK_8), files = P & (FILE_A | FILE_H);
+    for (int i = 0; i < 6; i++) {
+        stable |= ranks & (((stable << 1) & ~FILE_A) | ((stable >> 1) & ~FILE_H));
+        stable |= files & ((stable << 8) | (stable >> 8));
+    }
+    uint64_t filled = P | O;
+    if ((filled & RANK_1) == RANK_1) stable |= P & RANK_1;
+    if ((filled & RANK_8) == RANK_8) stable |= P & RANK_8;
+    if ((filled & FILE_A) == FILE_A) stable |= P & FILE_A;
+    if ((filled & FILE_H) == FILE_H) stable |= P & FILE_H;
+    return stable;
+}
+
+// Empty squares next to the opponent's discs (where the side to move may later play)
+inline uint64_t PotentialMoves(uint64_t O, uint64_t empty) {
+    uint64_t around = ((O << 1) & ~0x0101010101010101ULL) | ((O >> 1) & ~0x8080808080808080ULL);
+    around |= (around << 8) | (around >> 8) | (O << 8) | (O >> 8);
+    return around & empty;
+}
+
+// Sum of the weights of every pattern instance: table[offsets[i] + codes[i]]
+inline int PatternSumScalar(const uint16_t* codes, const uint32_t* offsets, const int16_t* table) {
+    int sum = 0;
+    for (int i = 0; i < EVAL_PATTERNS; i++) sum += table[offsets[i] + codes[i]];
+    return sum;
+}
+
+#if OTHELLO_X86_KERNELS
+// Gather 8 weights at a time; each 32-bit load holds the 16-bit weight in its low
+// half. The padding slots point at a zero weight.
+__attribute__((target("avx2")))
+inline int PatternSumAVX2(const uint16_t* codes, const uint32_t* offsets, const int16_t* table) {
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < EVAL_PATTERN_SLOTS; i += 8) {
+        __m256i code = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i)));
+        __m256i offset = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + i));
+        __m256i idx = _mm256_add_epi32(code, offset);
+        __m256i w = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), idx, 2);
+        sum = _mm256_add_epi32(sum, _mm256_srai_epi32(_mm256_slli_epi32(w, 16), 16));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s);
+}
+#endif
+
+typedef int (*PatternSumKernel)(const uint16_t* codes, const uint32_t* offsets, const int16_t* table);
+
+// AVX2 gather when the CPU has it, like the move kernels
+inline PatternSumKernel SelectPatternSum() {
+#if OTHELLO_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return PatternSumAVX2;
+#endif
+    return PatternSumScalar;
+}
+
+// Chosen once, before main(), for the whole process
+static const PatternSumKernel PATTERN_SUM = SelectPatternSum();
+
+// Per-thread evaluation state: the code of every pattern instance, updated with
+// vector adds on every move and restored from a saved copy on undo
+class Evaluator {
+    private:
+        struct Indices {
+            uint16_t v[EVAL_PATTERN_SLOTS];     // Pattern codes, 0 in the padding slots
+        };
+
+        Indices index;
+        std::vector<Indices> saved;     // Indices before each move still to be undone
+        size_t depth = 0;
+        const PatternSet* set;
+        const EvalWeights* weights;
+
+        int PatternSum(const int16_t* table) const {
+            return PATTERN_SUM(index.v, set->slotOffset, table);
+        }
+
+    public:
+        explicit Evaluator(const EvalWeights& weights = EvalWeights::Active())
+            : set(&PatternSet::Get()), weights(&weights) {}
+
+        // Compute all pattern codes from scratch
+        void Init(const Position& pos) {
+            const PatternSet& set = *this->set;
+            depth = 0;
+            for (int n = 0; n < EVAL_PATTERNS; n++) {
+                const int* squares = set.instanceSquares[n];
+                uint32_t code = 0;
+                for (int i = PatternSet::Types()[set.instanceType[n]].size - 1; i >= 0; i--)
+                    code = code * 3 + pos.bits.At(squares[i] / BOARD_SIZE, squares[i] % BOARD_SIZE);
+                index.v[n] = (uint16_t)code;
+            }
+            for (int n = EVAL_PATTERNS; n < EVAL_PATTERN_SLOTS; n++) index.v[n] = 0;
+        }
+
+        // player placed a disc on sq and flipped the given discs: every code moves by
+        // player * 3^k for the new disc and by +-3^k for each flipped one
+        void Play(Cell player, int sq, uint64_t flips) {
+            if (depth == saved.size()) saved.emplace_back();
+            saved[depth++] = index;
+
+            // Codes stay below 3^10 < 2^16, so 16-bit wraparound arithmetic is exact
+            uint16_t delta[EVAL_PATTERN_SLOTS];
+            const uint16_t* placed = set->squarePower[sq];
+            for (int i = 0; i < EVAL_PATTERN_SLOTS; i++) delta[i] = (uint16_t)(placed[i] * player);
+            if (player == Black_Disc) {     // White (2) -> black (1)
+                for (; flips; flips &= flips - 1) {
+                    const uint16_t* p = set->squarePower[LowestBit(flips)];
+                    for (int i = 0; i < EVAL_PATTERN_SLOTS; i++) delta[i] -= p[i];
+                }
+            } else {
+                for (; flips; flips &= flips - 1) {
+                    const uint16_t* p = set->squarePower[LowestBit(flips)];
+                    for (int i = 0; i < EVAL_PATTERN_SLOTS; i++) delta[i] += p[i];
+                }
+            }
+            for (int i = 0; i < EVAL_PATTERN_SLOTS; i++) index.v[i] += delta[i];
+        }
+
+        // Take back the last Play
+        void Undo() {
+            index = saved[--depth];
+        }
+
+        // Pattern code of instance n (for the training tool)
+        uint32_t Code(int n) const {
+            return index.v[n];
+        }
+
+        // Feature values from Black's point of view. The mobility feature generates
+        // EVAL_MOVE_GENS move sets.
+        static void Features(const Position& pos, int* out) {
+            uint64_t B = pos.bits.black, W = pos.bits.white, empty = pos.bits.Empty();
+            out[FEATURE_MOBILITY] = PopCount(GetMoves(B, W)) - PopCount(GetMoves(W, B));
+            out[FEATURE_POTENTIAL_MOBILITY] = PopCount(PotentialMoves(W, empty)) - PopCount(PotentialMoves(B, empty));
+            out[FEATURE_STABILITY] = PopCount(StableDiscs(B, W)) - PopCount(StableDiscs(W, B));
+        }
+
+        // Score for the side to move
+        int Score(const Position& pos) const {
+            int phase = EvalPhase(PopCount(pos.bits.Empty()));
+            int score = PatternSum(weights->Phase(phase));
+            int features[EVAL_FEATURES];
+            Features(pos, features);
+            for (int f = 0; f < EVAL_FEATURES; f++) score += weights->features[phase][f] * features[f];
+            score = std::max(-EVAL_MAX_SCORE, std::min(EVAL_MAX_SCORE, score));
+            return pos.currentPlayer == Black_Disc ? score : -score;
+        }
+};
+
+#endif
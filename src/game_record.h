@@ -0,0 +1,310 @@
+// Game records - full move lists in a compact block file, a streaming writer
+// and a zero-copy reader over a memory-mapped file
+#ifndef OTHELLO_GAME_RECORD_H
+#define OTHELLO_GAME_RECORD_H
+
+#include "mapped_file.h"
+#include "position.h"
+#include <algorithm>    // For min
+#include <cstring>      // For the headers
+#include <fstream>      // For the writer
+#include <stdexcept>    // For record file errors
+#include <string>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>     // For truncate
+#endif
+
+// File layout: a 16-byte file header, then blocks. Each block is a 16-byte block
+// header (tag, payload size, game count, checksum of the payload) followed by
+// its games; each game is a 16-byte game header followed by one byte per move
+// from the start position: the square 0-63, or MOVE_PASS.
+const char GAME_FILE_MAGIC[8] = {'O', 'T', 'H', 'G', 'A', 'M', 'E', '1'};
+const uint32_t GAME_BLOCK_TAG = 0x4B4C4247;         // "GBLK"
+const size_t GAME_BLOCK_BYTES = 64 * 1024;          // Writer closes a block at this payload size
+const uint8_t MOVE_PASS = 64;
+
+enum GameSource : uint8_t { SOURCE_UNKNOWN, SOURCE_TWO_PLAYERS, SOURCE_VS_AI, SOURCE_SELFPLAY };
+
+struct GameFileHeader {
+    char magic[8];
+    uint32_t reserved[2];
+};
+
+struct GameBlockHeader {
+    uint32_t tag;
+    uint32_t size;          // Payload bytes
+    uint32_t games;
+    uint32_t checksum;      // GameChecksum of the payload
+};
+
+// Stored unaligned in the payload, so it is read with memcpy
+struct GameHeader {
+    int64_t time;           // When the game ended (Unix time, 0 if unknown)
+    uint8_t moves;          // Move bytes that follow, passes included
+    uint8_t black;          // Final disc counts
+    uint8_t white;
+    uint8_t source;         // GameSource
+    uint8_t reserved[4];
+};
+static_assert(sizeof(GameHeader) == 16, "GameHeader must stay 16 bytes");
+
+// 32-bit FNV-1a
+inline uint32_t GameChecksum(const unsigned char* data, size_t size) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < size; i++) h = (h ^ data[i]) * 16777619u;
+    return h;
+}
+
+// Position after playing count move bytes from the start position; throws if
+// they are not a legal game
+inline Position ReplayMoves(const uint8_t* moves, size_t count) {
+    Position pos;
+    for (size_t i = 0; i < count; i++) {
+        if (moves[i] == MOVE_PASS) {
+            if (pos.LegalMoves() != 0) throw std::runtime_error("Pass with a legal move in a game record");
+            pos.Pass();
+        } else {
+            if (moves[i] >= 64 || !(pos.LegalMoves() & (1ULL << moves[i])))
+                throw std::runtime_error("Illegal move in a game record");
+            pos.MakeMove(moves[i]);
+        }
+    }
+    return pos;
+}
+
+// Moves of a game in the reader's mapping (valid while the reader is open)
+struct GameView {
+    GameHeader header;
+    const uint8_t* moves;
+
+    int MoveCount() const { return header.moves; }
+    int BlackDiff() const { return (int)header.black - (int)header.white; }
+
+    // Position after the first plies moves
+    Position PositionAfter(int plies) const {
+        return ReplayMoves(moves, std::min(plies, MoveCount()));
+    }
+};
+
+// Move bytes of a move list such as "f5d6c3" from the start position, with the
+// passes it implies inserted. Throws on an illegal move.
+inline std::vector<uint8_t> ParseMoveList(const std::string& text) {
+    std::vector<uint8_t> moves;
+    Position pos;
+    for (size_t i = 0; i < text.size(); ) {
+        if (text[i] == ' ' || text[i] == '\t' || text[i] == '\r') { i++; continue; }
+        int sq = ParseSquare(text.substr(i, 2));
+        if (pos.LegalMoves() == 0 && !pos.IsGameOver()) {
+            pos.Pass();
+            moves.push_back(MOVE_PASS);
+        }
+        if (sq < 0 || !(pos.LegalMoves() & (1ULL << sq)))
+            throw std::runtime_error("Illegal move '" + text.substr(i, 2) + "' in \"" + text + "\"");
+        pos.MakeMove(sq);
+        moves.push_back((uint8_t)sq);
+        i += 2;
+    }
+    return moves;
+}
+
+// Appends games to a record file, writing the file header if the file is new.
+// Games are buffered into blocks; Flush() writes the open block (do it after each
+// game when every game must survive a crash). A block or file header cut short
+// by a crash is cut off the file before appending. Not thread-safe.
+class GameWriter {
+    private:
+        std::ofstream out;
+        std::vector<unsigned char> block;
+        uint32_t blockGames = 0;
+
+        // Where a torn last block starts in an existing file of size bytes, or size
+        // if the file ends on a whole block. Damage before the last block (a bad
+        // tag, or a block whose size reaches a later block's tag) is left alone
+        // for the reader to skip.
+        static size_t TornTailStart(std::ifstream& in, size_t size) {
+            size_t offset = sizeof(GameFileHeader);
+            while (offset + sizeof(GameBlockHeader) <= size) {
+                GameBlockHeader header;
+                in.seekg((std::streamoff)offset);
+                in.read(reinterpret_cast<char*>(&header), sizeof header);
+                if (!in || header.tag != GAME_BLOCK_TAG) return size;
+                if (offset + sizeof header + header.size > size) break;
+                offset += sizeof header + header.size;
+            }
+            if (offset == size) return size;
+
+            std::vector<unsigned char> tail(size - offset);
+            in.seekg((std::streamoff)offset);
+            in.read(reinterpret_cast<char*>(tail.data()), (std::streamsize)tail.size());
+            if (!in) return size;
+            for (size_t at = 1; at + sizeof(uint32_t) <= tail.size(); at++) {
+                uint32_t tag;
+                std::memcpy(&tag, tail.data() + at, sizeof tag);
+                if (tag == GAME_BLOCK_TAG) return size;
+            }
+            return offset;
+        }
+
+        static void Truncate(const std::string& path, size_t size) {
+#if defined(__unix__) || defined(__APPLE__)
+            if (truncate(path.c_str(), (off_t)size) != 0) throw std::runtime_error("Failed to truncate " + path);
+#else
+            std::vector<char> kept(size);
+            std::ifstream in(path, std::ios::binary);
+            in.read(kept.data(), (std::streamsize)size);
+            in.close();
+            std::ofstream rewrite(path, std::ios::binary | std::ios::trunc);
+            rewrite.write(kept.data(), (std::streamsize)size);
+            if (!rewrite) throw std::runtime_error("Failed to rewrite " + path);
+#endif
+        }
+
+    public:
+        explicit GameWriter(const std::string& path) {
+            std::ifstream existing(path, std::ios::binary | std::ios::ate);
+            size_t size = existing ? (size_t)(std::streamoff)existing.tellg() : 0;
+            bool empty = size < sizeof(GameFileHeader);    // Missing, or its header never finished
+            size_t keep = 0;
+            if (!empty) {
+                GameFileHeader header;
+                existing.seekg(0);
+                existing.read(reinterpret_cast<char*>(&header), sizeof header);
+                if (!existing || std::memcmp(header.magic, GAME_FILE_MAGIC, sizeof header.magic) != 0)
+                    throw std::runtime_error(path + " is not a game record file");
+                keep = TornTailStart(existing, size);
+            }
+            existing.close();
+            if (size > 0 && keep < size) Truncate(path, keep);
+
+            out.open(path, std::ios::binary | std::ios::app);
+            if (!out) throw std::runtime_error("Failed to open " + path + " for writing");
+            if (empty) {
+                GameFileHeader header;
+                std::memcpy(header.magic, GAME_FILE_MAGIC, sizeof header.magic);
+                header.reserved[0] = header.reserved[1] = 0;
+                out.write(reinterpret_cast<const char*>(&header), sizeof header);
+            }
+        }
+
+        ~GameWriter() {
+            try { Flush(); } catch (...) {}
+        }
+
+        GameWriter(const GameWriter&) = delete;
+        GameWriter& operator=(const GameWriter&) = delete;
+
+        // moves: one byte per move from the start position, passes included
+        void Append(const std::vector<uint8_t>& moves, int black, int white, GameSource source, int64_t time) {
+            if (moves.size() > 255) throw std::runtime_error("Game record too long");
+            GameHeader header;
+            std::memset(&header, 0, sizeof header);
+            header.time = time;
+            header.moves = (uint8_t)moves.size();
+            header.black = (uint8_t)black;
+            header.white = (uint8_t)white;
+            header.source = source;
+            const unsigned char* h = reinterpret_cast<const unsigned char*>(&header);
+            block.insert(block.end(), h, h + sizeof header);
+            block.insert(block.end(), moves.begin(), moves.end());
+            blockGames++;
+            if (block.size() >= GAME_BLOCK_BYTES) Flush();
+        }
+
+        // Write the open block, if it has any games
+        void Flush() {
+            if (blockGames == 0) return;
+            GameBlockHeader header;
+            header.tag = GAME_BLOCK_TAG;
+            header.size = (uint32_t)block.size();
+            header.games = blockGames;
+            header.checksum = GameChecksum(block.data(), block.size());
+            out.write(reinterpret_cast<const char*>(&header), sizeof header);
+            out.write(reinterpret_cast<const char*>(block.data()), block.size());
+            out.flush();
+            block.clear();
+            blockGames = 0;
+            if (!out) throw std::runtime_error("Failed to write game records");
+        }
+};
+
+// Iterates the games of a mapped record file without copying them. A block that
+// fails its checksum or has no valid tag is skipped and counted, and reading
+// resumes at the next block tag after it, so a damaged block (e.g. one torn by a
+// crash and then appended after) loses no later games. A block cut short at the
+// end of the file (a writer that died mid-block) is not counted.
+class GameReader {
+    private:
+        MappedFile file;
+        size_t offset = 0;              // Next block header
+        const unsigned char* game = nullptr;    // Next game in the current block
+        const unsigned char* blockEnd = nullptr;
+        uint32_t gamesLeft = 0;         // In the current block
+        bool verify;
+        size_t badBlocks = 0;
+
+        // Offset of the next GAME_BLOCK_TAG after a bad block at offset
+        size_t Resync() const {
+            for (size_t at = offset + 1; at + sizeof(GameBlockHeader) <= file.Size(); at++) {
+                uint32_t tag;
+                std::memcpy(&tag, file.Data() + at, sizeof tag);
+                if (tag == GAME_BLOCK_TAG) return at;
+            }
+            return file.Size();
+        }
+
+        bool NextBlock() {
+            while (offset + sizeof(GameBlockHeader) <= file.Size()) {
+                GameBlockHeader header;
+                std::memcpy(&header, file.Data() + offset, sizeof header);
+                const unsigned char* payload = file.Data() + offset + sizeof header;
+                bool cutShort = header.tag == GAME_BLOCK_TAG && offset + sizeof header + header.size > file.Size();
+                if (header.tag != GAME_BLOCK_TAG || cutShort ||
+                    (verify && GameChecksum(payload, header.size) != header.checksum)) {
+                    if (!cutShort) badBlocks++;
+                    offset = Resync();
+                    continue;
+                }
+                offset += sizeof header + header.size;
+                game = payload;
+                blockEnd = payload + header.size;
+                gamesLeft = header.games;
+                return true;
+            }
+            return false;
+        }
+
+    public:
+        // Throws if the file cannot be mapped or is not a game record file
+        explicit GameReader(const std::string& path, bool verify = true) : verify(verify) {
+            file.Open(path, true);
+            GameFileHeader header;
+            if (file.Size() < sizeof header) throw std::runtime_error(path + " is not a game record file");
+            std::memcpy(&header, file.Data(), sizeof header);
+            if (std::memcmp(header.magic, GAME_FILE_MAGIC, sizeof header.magic) != 0)
+                throw std::runtime_error(path + " is not a game record file");
+            offset = sizeof header;
+        }
+
+        // Next game, false at the end of the file
+        bool Next(GameView& view) {
+            while (gamesLeft == 0 || game + sizeof(GameHeader) > blockEnd) {
+                gamesLeft = 0;
+                if (!NextBlock()) return false;
+            }
+            std::memcpy(&view.header, game, sizeof view.header);
+            view.moves = game + sizeof view.header;
+            game += sizeof view.header + view.header.moves;
+            gamesLeft--;
+            if (game > blockEnd) {      // Game runs past its block: treat the block as bad
+                badBlocks++;
+                gamesLeft = 0;
+                return Next(view);
+            }
+            return true;
+        }
+
+        size_t BadBlocks() const { return badBlocks; }
+};
+
+#endif
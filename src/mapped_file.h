@@ -0,0 +1,90 @@
+// Read-only memory-mapped file (training data, opening book, game records)
+#ifndef OTHELLO_MAPPED_FILE_H
+#define OTHELLO_MAPPED_FILE_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <vector>
+#endif
+
+// Maps a whole file into memory, so large files are paged in on demand and
+// shared between threads without copies. Without mmap the file is read in.
+class MappedFile {
+    private:
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+#if !(defined(__unix__) || defined(__APPLE__))
+        std::vector<unsigned char> buffer;
+#endif
+
+    public:
+        MappedFile() {}
+
+        explicit MappedFile(const std::string& path) {
+            Open(path);
+        }
+
+        ~MappedFile() {
+            Close();
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Throws if the file cannot be opened or mapped
+        void Open(const std::string& path, bool sequential = false) {
+            Close();
+#if defined(__unix__) || defined(__APPLE__)
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) throw std::runtime_error("Failed to open " + path);
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                close(fd);
+                throw std::runtime_error("Failed to read the size of " + path);
+            }
+            size = (size_t)st.st_size;
+            if (size > 0) {
+                void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED) {
+                    close(fd);
+                    size = 0;
+                    throw std::runtime_error("Failed to map " + path);
+                }
+                madvise(p, size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+                data = static_cast<const unsigned char*>(p);
+            }
+            close(fd);              // The mapping stays valid
+#else
+            (void)sequential;
+            std::ifstream file(path, std::ios::binary);
+            if (!file) throw std::runtime_error("Failed to open " + path);
+            buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            data = buffer.data();
+            size = buffer.size();
+#endif
+        }
+
+        void Close() {
+#if defined(__unix__) || defined(__APPLE__)
+            if (data) munmap(const_cast<unsigned char*>(data), size);
+#else
+            buffer.clear();
+#endif
+            data = nullptr;
+            size = 0;
+        }
+
+        bool IsOpen() const { return data != nullptr; }
+        const unsigned char* Data() const { return data; }
+        size_t Size() const { return size; }
+};
+
+#endif
@@ -0,0 +1,235 @@
+// Move-generation kernels - portable scalar code plus AVX2 and BMI2 versions for
+// x86-64, compiled into every build and picked at startup from what the CPU supports
+#ifndef OTHELLO_MOVE_KERNELS_H
+#define OTHELLO_MOVE_KERNELS_H
+
+#include <cstdint>      // For 64-bit bitboard masks
+#include <vector>       // For the list of usable kernels
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define OTHELLO_X86_KERNELS 1
+#include <immintrin.h>  // Usable inside target("...") functions whatever the build flags
+#else
+#define OTHELLO_X86_KERNELS 0
+#endif
+
+// Bitboard helpers - bit index is row * 8 + col, one 64-bit mask per colour
+const uint64_t INNER_COLS = 0x7E7E7E7E7E7E7E7EULL;  // Columns 1-6 (no wrap on horizontal shifts)
+const uint64_t INNER_ROWS = 0x00FFFFFFFFFFFF00ULL;  // Rows 1-6
+const uint64_t INNER_DIAG = INNER_COLS & INNER_ROWS;
+
+// Discs of P that bracket a run of masked O discs along one shift direction
+inline uint64_t MovesLeft(uint64_t P, uint64_t O, int s) {
+    uint64_t f = O & (P << s);
+    f |= O & (f << s);
+    uint64_t pair = O & (O << s);      // Two O discs in a row: extend the run two squares at a time
+    f |= pair & (f << (2 * s));
+    f |= pair & (f << (2 * s));
+    return f << s;
+}
+
+inline uint64_t MovesRight(uint64_t P, uint64_t O, int s) {
+    uint64_t f = O & (P >> s);
+    f |= O & (f >> s);
+    uint64_t pair = O & (O >> s);
+    f |= pair & (f >> (2 * s));
+    f |= pair & (f >> (2 * s));
+    return f >> s;
+}
+
+// All legal moves for the player owning P against O, as a mask of empty squares
+inline uint64_t GetMovesScalar(uint64_t P, uint64_t O) {
+    uint64_t h = O & INNER_COLS, v = O & INNER_ROWS, d = O & INNER_DIAG;
+    uint64_t moves = MovesLeft(P, h, 1) | MovesRight(P, h, 1)
+                   | MovesLeft(P, v, 8) | MovesRight(P, v, 8)
+                   | MovesLeft(P, d, 7) | MovesRight(P, d, 7)
+                   | MovesLeft(P, d, 9) | MovesRight(P, d, 9);
+    return moves & ~(P | O);
+}
+
+// Run of O discs starting next to the move, kept only if it is closed by a P disc
+inline uint64_t FlipsLeft(uint64_t P, uint64_t O, uint64_t m, int s) {
+    uint64_t f = O & (m << s);
+    f |= O & (f << s); f |= O & (f << s); f |= O & (f << s);
+    f |= O & (f << s); f |= O & (f << s);
+    return f & (0 - (uint64_t)(((f << s) & P) != 0));
+}
+
+inline uint64_t FlipsRight(uint64_t P, uint64_t O, uint64_t m, int s) {
+    uint64_t f = O & (m >> s);
+    f |= O & (f >> s); f |= O & (f >> s); f |= O & (f >> s);
+    f |= O & (f >> s); f |= O & (f >> s);
+    return f & (0 - (uint64_t)(((f >> s) & P) != 0));
+}
+
+// Discs flipped when the player owning P plays on the empty square sq (0 if the move is illegal)
+inline uint64_t GetFlipsScalar(uint64_t P, uint64_t O, int sq) {
+    uint64_t m = 1ULL << sq;
+    uint64_t h = O & INNER_COLS, v = O & INNER_ROWS, d = O & INNER_DIAG;
+    return FlipsLeft(P, h, m, 1) | FlipsRight(P, h, m, 1)
+         | FlipsLeft(P, v, m, 8) | FlipsRight(P, v, m, 8)
+         | FlipsLeft(P, d, m, 7) | FlipsRight(P, d, m, 7)
+         | FlipsLeft(P, d, m, 9) | FlipsRight(P, d, m, 9);
+}
+
+// Lookup tables of the BMI2 flips. Each square lies on four lines (row, column,
+// diagonal, anti-diagonal); a line is gathered into the low bits of a byte with
+// pext, looked up, and the flips are scattered back with pdep.
+struct LineFlipTables {
+    uint64_t lines[64][4];          // Squares of each line through a square
+    uint8_t index[64][4];           // Position of the square within that line
+    uint8_t outflank[8][256];       // [position][O on the line]: where a P disc closes a run
+    uint8_t flipped[8][256];        // [position][closing P discs]: the discs between
+
+    constexpr LineFlipTables() : lines{}, index{}, outflank{}, flipped{} {
+        for (int sq = 0; sq < 64; sq++) {
+            int row = sq / 8, col = sq % 8;
+            for (int other = 0; other < 64; other++) {
+                int r = other / 8, c = other % 8;
+                uint64_t bit = 1ULL << other;
+                if (r == row) lines[sq][0] |= bit;
+                if (c == col) lines[sq][1] |= bit;
+                if (r - c == row - col) lines[sq][2] |= bit;
+                if (r + c == row + col) lines[sq][3] |= bit;
+            }
+            for (int d = 0; d < 4; d++) {
+                int below = 0;
+                for (int other = 0; other < sq; other++) below += (lines[sq][d] >> other) & 1;
+                index[sq][d] = (uint8_t)below;
+            }
+        }
+        for (int k = 0; k < 8; k++) {
+            for (int o = 0; o < 256; o++) {
+                int i = k + 1;
+                while (i < 8 && ((o >> i) & 1)) i++;
+                if (i > k + 1 && i < 8) outflank[k][o] |= (uint8_t)(1 << i);
+                i = k - 1;
+                while (i >= 0 && ((o >> i) & 1)) i--;
+                if (i < k - 1 && i >= 0) outflank[k][o] |= (uint8_t)(1 << i);
+            }
+            for (int out = 0; out < 256; out++) {
+                for (int j = 0; j < 8; j++) {
+                    if (!((out >> j) & 1)) continue;
+                    for (int b = j < k ? j + 1 : k + 1; b < (j < k ? k : j); b++) flipped[k][out] |= (uint8_t)(1 << b);
+                }
+            }
+        }
+    }
+};
+
+#if OTHELLO_X86_KERNELS
+static constexpr LineFlipTables LINE_FLIPS{};
+
+// The four directions side by side: lane shifts 1 (rows), 8 (columns), 9 and 7
+// (diagonals), each with the opponent mask that stops it wrapping round an edge
+__attribute__((target("avx2")))
+inline uint64_t GetMovesAVX2(uint64_t P, uint64_t O) {
+    const __m256i shift = _mm256_set_epi64x(7, 9, 8, 1);
+    const __m256i shift2 = _mm256_add_epi64(shift, shift);
+    __m256i PP = _mm256_set1_epi64x((long long)P);
+    __m256i OO = _mm256_and_si256(_mm256_set1_epi64x((long long)O),
+                                  _mm256_set_epi64x((long long)INNER_DIAG, (long long)INNER_DIAG,
+                                                    (long long)INNER_ROWS, (long long)INNER_COLS));
+
+    __m256i fl = _mm256_and_si256(OO, _mm256_sllv_epi64(PP, shift));
+    __m256i fr = _mm256_and_si256(OO, _mm256_srlv_epi64(PP, shift));
+    fl = _mm256_or_si256(fl, _mm256_and_si256(OO, _mm256_sllv_epi64(fl, shift)));
+    fr = _mm256_or_si256(fr, _mm256_and_si256(OO, _mm256_srlv_epi64(fr, shift)));
+    __m256i pl = _mm256_and_si256(OO, _mm256_sllv_epi64(OO, shift));
+    __m256i pr = _mm256_srlv_epi64(pl, shift);
+    fl = _mm256_or_si256(fl, _mm256_and_si256(pl, _mm256_sllv_epi64(fl, shift2)));
+    fr = _mm256_or_si256(fr, _mm256_and_si256(pr, _mm256_srlv_epi64(fr, shift2)));
+    fl = _mm256_or_si256(fl, _mm256_and_si256(pl, _mm256_sllv_epi64(fl, shift2)));
+    fr = _mm256_or_si256(fr, _mm256_and_si256(pr, _mm256_srlv_epi64(fr, shift2)));
+    __m256i moves = _mm256_or_si256(_mm256_sllv_epi64(fl, shift), _mm256_srlv_epi64(fr, shift));
+
+    __m128i m = _mm_or_si128(_mm256_castsi256_si128(moves), _mm256_extracti128_si256(moves, 1));
+    m = _mm_or_si128(m, _mm_unpackhi_epi64(m, m));
+    return (uint64_t)_mm_cvtsi128_si64(m) & ~(P | O);
+}
+
+__attribute__((target("avx2")))
+inline uint64_t GetFlipsAVX2(uint64_t P, uint64_t O, int sq) {
+    const __m256i shift = _mm256_set_epi64x(7, 9, 8, 1);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i PP = _mm256_set1_epi64x((long long)P);
+    __m256i MM = _mm256_set1_epi64x((long long)(1ULL << sq));
+    __m256i OO = _mm256_and_si256(_mm256_set1_epi64x((long long)O),
+                                  _mm256_set_epi64x((long long)INNER_DIAG, (long long)INNER_DIAG,
+                                                    (long long)INNER_ROWS, (long long)INNER_COLS));
+
+    __m256i fl = _mm256_and_si256(OO, _mm256_sllv_epi64(MM, shift));
+    __m256i fr = _mm256_and_si256(OO, _mm256_srlv_epi64(MM, shift));
+    for (int i = 0; i < 5; i++) {
+        fl = _mm256_or_si256(fl, _mm256_and_si256(OO, _mm256_sllv_epi64(fl, shift)));
+        fr = _mm256_or_si256(fr, _mm256_and_si256(OO, _mm256_srlv_epi64(fr, shift)));
+    }
+    // Keep a run only where the square past it holds a P disc
+    __m256i closedL = _mm256_and_si256(_mm256_sllv_epi64(fl, shift), PP);
+    __m256i closedR = _mm256_and_si256(_mm256_srlv_epi64(fr, shift), PP);
+    fl = _mm256_andnot_si256(_mm256_cmpeq_epi64(closedL, zero), fl);
+    fr = _mm256_andnot_si256(_mm256_cmpeq_epi64(closedR, zero), fr);
+    __m256i flips = _mm256_or_si256(fl, fr);
+
+    __m128i f = _mm_or_si128(_mm256_castsi256_si128(flips), _mm256_extracti128_si256(flips, 1));
+    f = _mm_or_si128(f, _mm_unpackhi_epi64(f, f));
+    return (uint64_t)_mm_cvtsi128_si64(f);
+}
+
+__attribute__((target("bmi2")))
+inline uint64_t GetFlipsBMI2(uint64_t P, uint64_t O, int sq) {
+    uint64_t flips = 0;
+    for (int d = 0; d < 4; d++) {
+        uint64_t line = LINE_FLIPS.lines[sq][d];
+        int k = LINE_FLIPS.index[sq][d];
+        unsigned out = LINE_FLIPS.outflank[k][_pext_u64(O, line)] & (unsigned)_pext_u64(P, line);
+        flips |= _pdep_u64(LINE_FLIPS.flipped[k][out], line);
+    }
+    return flips;
+}
+#endif
+
+// One implementation of each kernel
+struct MoveKernels {
+    const char* name;
+    uint64_t (*moves)(uint64_t P, uint64_t O);
+    uint64_t (*flips)(uint64_t P, uint64_t O, int sq);
+};
+
+// Every kernel set this CPU can run, the portable one first
+inline std::vector<MoveKernels> UsableKernels() {
+    std::vector<MoveKernels> kernels;
+    kernels.push_back({"scalar", GetMovesScalar, GetFlipsScalar});
+#if OTHELLO_X86_KERNELS
+    __builtin_cpu_init();
+    bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2) kernels.push_back({"avx2", GetMovesAVX2, GetFlipsAVX2});
+    if (__builtin_cpu_supports("bmi2"))
+        kernels.push_back({"bmi2", avx2 ? GetMovesAVX2 : GetMovesScalar, GetFlipsBMI2});
+#endif
+    return kernels;
+}
+
+// Fastest usable set: BMI2 flips with AVX2 moves, except on AMD before Zen 3,
+// whose pext and pdep are microcoded and slower than the shifts
+inline MoveKernels SelectKernels() {
+    std::vector<MoveKernels> kernels = UsableKernels();
+#if OTHELLO_X86_KERNELS
+    bool slowPext = __builtin_cpu_is("amdfam15h") || __builtin_cpu_is("amdfam17h");
+    if (slowPext && kernels.back().flips == GetFlipsBMI2) kernels.pop_back();
+#endif
+    return kernels.back();
+}
+
+// Chosen once, before main(), for the whole process
+static const MoveKernels ACTIVE_KERNELS = SelectKernels();
+
+inline uint64_t GetMoves(uint64_t P, uint64_t O) {
+    return ACTIVE_KERNELS.moves(P, O);
+}
+
+inline uint64_t GetFlips(uint64_t P, uint64_t O, int sq) {
+    return ACTIVE_KERNELS.flips(P, O, sq);
+}
+
+#endif
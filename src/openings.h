@@ -0,0 +1,75 @@
+// Opening sets for engine matches - read from a file or enumerated from the start position
+#ifndef OTHELLO_OPENINGS_H
+#define OTHELLO_OPENINGS_H
+
+#include "position.h"
+#include "symmetry.h"
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+struct Opening {
+    std::string moves;      // Move list from the start position, e.g. "f5d6c3"
+    Position pos;           // Position after those moves
+};
+
+// Play a move list such as "f5d6c3" or "f5 d6 c3" from the start position.
+// A side without legal moves passes automatically. Throws on an illegal move.
+inline Position PlayMoves(const std::string& moves) {
+    Position pos;
+    for (size_t i = 0; i < moves.size(); ) {
+        if (moves[i] == ' ' || moves[i] == '\t' || moves[i] == '\r') { i++; continue; }
+
+        int sq = ParseSquare(moves.substr(i, 2));
+        if (pos.LegalMoves() == 0 && !pos.IsGameOver()) pos.Pass();
+        if (sq < 0 || !(pos.LegalMoves() & (1ULL << sq)))
+            throw std::runtime_error("Illegal move '" + moves.substr(i, 2) + "' in \"" + moves + "\"");
+        pos.MakeMove(sq);
+        i += 2;
+    }
+    if (pos.LegalMoves() == 0 && !pos.IsGameOver()) pos.Pass();
+    return pos;
+}
+
+// One opening per line as a move list; blank lines and '#' comments are skipped
+inline std::vector<Opening> LoadOpenings(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("Failed to open openings file " + path);
+
+    std::vector<Opening> openings;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        openings.push_back({ line, PlayMoves(line) });
+    }
+    return openings;
+}
+
+// Every distinct position reached after exactly plies moves, in move-generation order.
+// With distinctBySymmetry, rotated or mirrored copies of an earlier opening are dropped.
+inline std::vector<Opening> EnumerateOpenings(int plies, bool distinctBySymmetry = false) {
+    std::vector<Opening> frontier(1), next;
+    for (int ply = 0; ply < plies; ply++) {
+        std::unordered_set<uint64_t> seen;
+        next.clear();
+        for (const Opening& o : frontier) {
+            for (uint64_t moves = o.pos.LegalMoves(); moves; moves &= moves - 1) {
+                Opening child = o;
+                int sq = LowestBit(moves);
+                child.pos.MakeMove(sq);
+                child.moves += SquareName(sq);
+                if (child.pos.LegalMoves() == 0 && !child.pos.IsGameOver()) child.pos.Pass();
+                uint64_t key = distinctBySymmetry ? CanonicalKey(child.pos) : child.pos.hash;
+                if (seen.insert(key).second) next.push_back(child);
+            }
+        }
+        frontier.swap(next);
+    }
+    return frontier;
+}
+
+#endif
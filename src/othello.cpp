@@ -1,21 +1,38 @@
 // All necessary libraries
 #include "raylib.h"     // For graphics and input handling
+#include "player.h"     // For the rules, the AI engine and the Player interface
+#include "score_store.h"    // For the score history
+#include "game_record.h"    // For the game move log
+#include "analysis.h"       // For the move hints
 #include <iostream>     // For console output
-#include <climits>      // For INT_MIN/MAX constants
 #include <fstream>      // For file handling
 #include <ctime>        // For date/time functions
+#include <memory>       // For the game log writer
+#include <vector>       // For the moves of the current game
 #include <stdexcept>    // For standard exceptions
 using namespace std;
 
 const int SCREEN_WIDTH = 640;   // Window width
 const int SCREEN_HEIGHT = 640;  // Window height
-const int BOARD_SIZE = 8;       // 8x8 Othello board
 const int CELL_SIZE = SCREEN_WIDTH / BOARD_SIZE;    // Size of each cell
+const char* const WEIGHTS_FILE = "weights.bin";     // Trained evaluation weights (see tools/train.cpp)
+const char* const BOOK_FILE = "book.bin";           // Opening book (see tools/book.cpp)
+const char* const SCORES_FILE = "scores.bin";       // Score history log
+const char* const LEGACY_SCORES_FILE = "scores.txt";    // Text history, imported into a new log
+const char* const GAMES_FILE = "games.bin";         // Move lists of finished games (see src/game_record.h)
+const int SCORES_PER_PAGE = 12;     // Games listed per score history page
 
 // Game enumerations
-enum Cell { EMPTY, Black_Disc, White_Disc };    // Possible cell states
 enum GameState { MENU, MODE_SELECTION, GAMEPLAY, HOW_TO_PLAY, SCORE_HISTORY };  // Game screens
-enum GameResult { NONE, BLACK_WINS, WHITE_WINS, DRAW }; // Game outcomes
+
+// Any mouse, wheel, key or window event since the last PollInputEvents
+static bool InputArrived() {
+    Vector2 delta = GetMouseDelta();
+    if (delta.x != 0 || delta.y != 0 || GetMouseWheelMove() != 0) return true;
+    for (int button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_MIDDLE; button++)
+        if (IsMouseButtonPressed(button) || IsMouseButtonReleased(button)) return true;
+    return GetKeyPressed() != 0 || IsWindowResized();
+}
 
 // Utility for drawing button
 static bool DrawButton(Rectangle bounds, const char* text) {
@@ -35,57 +52,53 @@ static bool DrawSmallButton(Rectangle bounds, const char* text, int fontSize = 2
 }
 
 // Board class - represents the Othello game board
-class Board {
+// The search Position lives in the base class; Board adds the GUI state on top
+class Board : public Position {
     private:
         float flipProgress[8][8] = {0};     // Animation progress for each cell
 
     public:
-        Cell board[BOARD_SIZE][BOARD_SIZE];     // 2D array representing the board
-        Cell currentPlayer;                     // Current player (black or white)
-        bool validMoves[8][8];                  // Track valid moves for highlighting
+        // Derived from the position by Refresh() whenever it changes, so frames
+        // that only redraw never run move generation
+        uint64_t legalMoves = 0;        // Moves of the side to move
+        int blackCount = 0;             // Discs on the board
+        int whiteCount = 0;
+        bool noMovesLeft = false;       // Neither side can move: the game is over
 
         // Constructor - initialize board and starting player
         Board(){
-            currentPlayer = Black_Disc;
             Initialize_Board();
         }
 
-        // Calculate all valid moves for a player
-        void ComputeValidMoves(Cell player)
-        {
-            for (int row = 0; row < 8; ++row) {
-                for (int col = 0; col < 8; ++col) {
-                    validMoves[row][col] = IsValidMove(row, col, player);
-                }
-            }
+        // Contents of a cell
+        Cell At(int row, int col) const {
+            return bits.At(row, col);
         }
 
-        // Check if a move is valid for a specific player
-        bool IsValidMove(int row, int col, Cell player)
-        {
-                if (board[row][col] != EMPTY) return false;     // Can't place on occupied cell
+        // Recompute the derived state after the position changed
+        void Refresh() {
+            legalMoves = LegalMoves();
+            blackCount = PopCount(bits.black);
+            whiteCount = PopCount(bits.white);
+            noMovesLeft = legalMoves == 0 && bits.LegalMoves(Opponent(currentPlayer)) == 0;
+        }
 
-                // Temporarily set to check moves for this player
-                Cell tempPlayer = currentPlayer;
-                currentPlayer = player;  
-                bool isValid = CanPlace(col, row, false);   // Check without flipping
-                currentPlayer = tempPlayer;  // Restore original player
-                
-                return isValid;
+        // Check if a move is valid for the side to move
+        bool IsValidMove(int row, int col) const
+        {
+                return (legalMoves & SquareBit(row, col)) != 0;
         }
 
         // Initialize the board with starting positions
         void Initialize_Board() {
-            // Clear the board
-            for (int row = 0; row < BOARD_SIZE; row++)
-                for (int col = 0; col < BOARD_SIZE; col++)
-                    board[row][col] = EMPTY;
-            
-            // Set up the initial 4 pieces in the center
-            board[3][3] = White_Disc;
-            board[3][4] = Black_Disc;
-            board[4][3] = Black_Disc;
-            board[4][4] = White_Disc;
+            Reset();    // Initial 4 pieces in the center, Black to move
+            Refresh();
+        }
+
+        // Hand the turn to the other side
+        void Pass() {
+            Position::Pass();
+            Refresh();
         }
         
         // Check if coordinates are within board boundaries
@@ -94,63 +107,50 @@ class Board {
         }
 
         void UpdateAnimations() {
+            // The first frame after waiting for input reports the whole wait; cap it
+            // so a flip started on that frame is still animated
+            float frameTime = min(GetFrameTime(), 1.0f / 30);
             for(int y = 0; y < 8; y++) {
                 for(int x = 0; x < 8; x++) {
                     if(flipProgress[y][x] > 0) {
-                        flipProgress[y][x] -= GetFrameTime() * 4;
+                        flipProgress[y][x] -= frameTime * 4;
                         if(flipProgress[y][x] < 0) flipProgress[y][x] = 0;
                     }
                 }
             }
         }
 
-        // Try to flip pieces in a direction (dx, dy)
-        bool TryFlip(int x, int y, int dx, int dy, bool flip) {
-            int cx = x + dx;
-            int cy = y + dy;
-            int count = 0;
-            
-            // Move in direction until we find our own piece or edge
-            while (Is_Within_Boundaries(cx, cy) && board[cy][cx] == (currentPlayer == Black_Disc ? White_Disc : Black_Disc)) {
-                cx += dx;
-                cy += dy;
-                count++;
-            }
-            
-            // If we found our own piece after opponent's pieces, it's valid
-            if (count > 0 && Is_Within_Boundaries(cx, cy) && board[cy][cx] == currentPlayer) {
-                if (flip) {     // Actually flip the pieces if requested
-                    for (int i = 1; i <= count; i++){
-                        board[y + i * dy][x + i * dx] = currentPlayer;
-                        flipProgress[y + i * dy][x + i * dx] = 1.0f; // Start animation
-                    }
-                }
-                return true;
-            }
-    
+        // Any flip animation still running
+        bool IsAnimating() const {
+            for(int y = 0; y < 8; y++)
+                for(int x = 0; x < 8; x++)
+                    if(flipProgress[y][x] > 0) return true;
             return false;
         }
-        
-        // Check if a piece can be placed at (x,y)
+
+        // Check if a piece can be placed at (x,y); if flip is set, also play the move
+        // (place, flip the outflanked discs and pass the turn to the opponent)
         bool CanPlace(int x, int y, bool flip) {
-            if (board[y][x] != EMPTY) return false; // Cell must be empty
-    
-            bool valid = false;
-            // Check all 8 directions around the cell
-            for (int dy = -1; dy <= 1; dy++)
-                for (int dx = -1; dx <= 1; dx++)
-                    if (!(dx == 0 && dy == 0))  // Skip the current cell
-                        valid |= TryFlip(x, y, dx, dy, flip);
-    
-            return valid;
+            int sq = y * BOARD_SIZE + x;
+            if (!(bits.Empty() & (1ULL << sq))) return false; // Cell must be empty
+
+            uint64_t flips = bits.Flips(currentPlayer, sq);
+            if (flips == 0) return false;   // Must outflank at least one disc
+
+            if (flip) {
+                MakeMove(sq);
+                Refresh();
+                for (uint64_t f = flips; f; f &= f - 1) {
+                    int i = LowestBit(f);
+                    flipProgress[i / BOARD_SIZE][i % BOARD_SIZE] = 1.0f; // Start animation
+                }
+            }
+            return true;
         }
         
         // Place a piece on the board if valid
         void PlacePiece(int x, int y) {
-            if (CanPlace(x, y, true)) { // Check and flip pieces
-                board[y][x] = currentPlayer;
-                currentPlayer = (currentPlayer == Black_Disc) ? White_Disc : Black_Disc;
-            }
+            CanPlace(x, y, true);   // Check, place, flip pieces and pass the turn
         }
 
         // Draw the game board
@@ -164,28 +164,28 @@ class Board {
 
             ClearBackground(Board_Background_Color);
 
+            // Highlight the hovered cell if it is a valid move
+            if(showHighlights){
+                Vector2 mousePos = GetMousePosition();
+                int hoverX = mousePos.x / CELL_SIZE;
+                int hoverY = mousePos.y / CELL_SIZE;
+
+                if (Is_Within_Boundaries(hoverX, hoverY) && IsValidMove(hoverY, hoverX)) {
+                    DrawRectangle(hoverX * CELL_SIZE, hoverY * CELL_SIZE,
+                                CELL_SIZE, CELL_SIZE, Fade(LIGHTGRAY, 0.2f));
+                }
+            }
+
             // Draw each cell
             for (int y = 0; y < BOARD_SIZE; y++) {
                 for (int x = 0; x < BOARD_SIZE; x++) {
                     // Draw grid lines
                     DrawRectangleLines(x * CELL_SIZE, y * CELL_SIZE, CELL_SIZE, CELL_SIZE, Grid_Line_Color);
 
-                    // Highlights
-                    if(showHighlights){
-                        Vector2 mousePos = GetMousePosition();
-                        int hoverX = mousePos.x / CELL_SIZE;
-                        int hoverY = mousePos.y / CELL_SIZE;
-
-                        if (Is_Within_Boundaries(hoverX, hoverY)) {
-                            if (board[hoverY][hoverX] == EMPTY && IsValidMove(hoverY, hoverX, currentPlayer)) {
-                                DrawRectangle(hoverX * CELL_SIZE, hoverY * CELL_SIZE, 
-                                            CELL_SIZE, CELL_SIZE, Fade(LIGHTGRAY, 0.2f));
-                            }
-                        }
-                    }
                     // Draw disc if present
-                    if (board[y][x] != EMPTY) {
-                        Color Disc_Color = (board[y][x] == Black_Disc) ? Black_Disc_Color : White_Disc_Color;
+                    Cell cell = At(y, x);
+                    if (cell != EMPTY) {
+                        Color Disc_Color = (cell == Black_Disc) ? Black_Disc_Color : White_Disc_Color;
                         float scale = 1.0f - flipProgress[y][x];
                         float radius = (CELL_SIZE / 2 - 5) * scale;
                         DrawCircle(x * CELL_SIZE + CELL_SIZE / 2, 
@@ -194,199 +194,92 @@ class Board {
                     }
 
                     // Highlight valid moves for current player
-                    else if (IsValidMove(y, x, currentPlayer)) {
+                    else if (IsValidMove(y, x)) {
                         DrawCircle(x * CELL_SIZE + CELL_SIZE / 2, y * CELL_SIZE + CELL_SIZE / 2, 7, Highlight_Color);
                     }
                 }
             }
         }
 
-        // Create a copy of the board
-        Board Clone() {
-            Board copy;
-            for (int y = 0; y < BOARD_SIZE; y++)
-                for (int x = 0; x < BOARD_SIZE; x++)
-                    copy.board[y][x] = board[y][x];
-            copy.currentPlayer = currentPlayer;
-            return copy;
-        }
-
         // Check if a player has any valid moves
-        bool HasValidMove(bool isWhite) {
-            for (int y = 0; y < BOARD_SIZE; y++) {
-                for (int x = 0; x < BOARD_SIZE; x++) {
-                    if (board[y][x] == EMPTY && CanPlace(x, y, isWhite)) {
-                        return true;
-                    }
-                }
-            }
-            return false;
+        bool HasValidMove(Cell player) {
+            return bits.LegalMoves(player) != 0;
         }  
                       
     };
 
-// Human player implementation
-class Player {
-    public:
-        virtual void MakeMove(Board& board, GameResult& result, bool& gameOver) = 0;
-        virtual void ShowScore(int blackCount, int whiteCount) = 0;
-        virtual void ReturnToMenu(GameState& gameState) = 0;
-        virtual ~Player() {}
-    };
- 
+
+
+// Human player implementation - moves on a mouse click
 class HumanPlayer : public Player {
     public:
-        void MakeMove(Board& board, GameResult& result, bool& gameOver) override {
+        int ChooseMove(const Position& pos) override {
             if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
                 Vector2 mouse = GetMousePosition();
                 int x = mouse.x / CELL_SIZE;
                 int y = mouse.y / CELL_SIZE;
-                if (board.Is_Within_Boundaries(x, y)) {
-                    if (board.CanPlace(x, y, false)) {
-                        board.PlacePiece(x, y);
+                if (x >= 0 && x < BOARD_SIZE && y >= 0 && y < BOARD_SIZE) {
+                    if (pos.LegalMoves() & SquareBit(y, x)) {
+                        return y * BOARD_SIZE + x;
                     }
                 }
             }
+            return -1;
         }
 
         void ShowScore(int blackCount, int whiteCount) override {
             cout << "Black: " << blackCount << " | White: " << whiteCount << "\n";
         }
-
-        void ReturnToMenu(GameState& gameState) override {
-            gameState = MENU;
-        }
 };
 
-// AI player implementation
-class AIPlayer : public Player {
-    public:
-        // Simplified evaluation: prioritize corners and discourage edges
-        int EvaluateBoard(Board& board) {
-            int score = 0;
-            const int weight[8][8] = {
-                {100, -20, 10, 5, 5, 10, -20, 100},
-                {-20, -50, -2, -2, -2, -2, -50, -20},
-                {10, -2, 0, 0, 0, 0, -2, 10},
-                {5, -2, 0, 0, 0, 0, -2, 5},
-                {5, -2, 0, 0, 0, 0, -2, 5},
-                {10, -2, 0, 0, 0, 0, -2, 10},
-                {-20, -50, -2, -2, -2, -2, -50, -20},
-                {100, -20, 10, 5, 5, 10, -20, 100}
-            };
-
-            for (int y = 0; y < BOARD_SIZE; y++) {
-                for (int x = 0; x < BOARD_SIZE; x++) {
-                    if (board.board[y][x] == Black_Disc) score += weight[y][x];
-                    else if (board.board[y][x] == White_Disc) score -= weight[y][x];
-                }
-            }
-            return score;
-        }
-
-        int Minimax(Board& board, int depth, bool isMax, int alpha, int beta) {
-            if (depth == 0) return EvaluateBoard(board);
-
-            int bestScore = isMax ? INT_MIN : INT_MAX;
-            bool moveAvailable = false;
-
-            for (int y = 0; y < BOARD_SIZE; y++) {
-                for (int x = 0; x < BOARD_SIZE; x++) {
-                    if (board.board[y][x] == EMPTY && board.CanPlace(x, y, isMax)) {
-                        moveAvailable = true;
-                        Board newBoard = board.Clone();
-                        newBoard.PlacePiece(x, y);
-                        int score = Minimax(newBoard, depth - 1, !isMax, alpha, beta);
-
-                        if (isMax) {
-                            bestScore =  max(bestScore, score);
-                            alpha =  max(alpha, bestScore);
-                        } else {
-                            bestScore =  min(bestScore, score);
-                            beta =  min(beta, bestScore);
-                        }
-
-                        if (beta <= alpha) break;
-                    }
-                }
-            }
-            return moveAvailable ? bestScore : EvaluateBoard(board);
-        }
-
-        void MakeMove(Board& board, GameResult& result, bool& gameOver) override {
-            int bestScore = INT_MIN;
-            int moveX = -1, moveY = -1;
-
-            for (int y = 0; y < BOARD_SIZE; y++) {
-                for (int x = 0; x < BOARD_SIZE; x++) {
-                    if (board.board[y][x] == EMPTY && board.CanPlace(x, y, false)) {
-                        Board newBoard = board.Clone();
-                        newBoard.PlacePiece(x, y);
-                        int score = Minimax(newBoard, 2, true, INT_MIN, INT_MAX); // Depth = 2 for speed
-
-                        if (score > bestScore) {
-                            bestScore = score;
-                            moveX = x;
-                            moveY = y;
-                        }
-                    }
-                }
-            }
-
-            if (moveX != -1 && moveY != -1) {
-                board.PlacePiece(moveX, moveY);
-            } else {
-                cout << "AI has no valid moves. Passing...\n";
-            }
-        }
-
-        void ShowScore(int blackCount, int whiteCount) override {
-            cout << "AI Score - Black: " << blackCount << " | White: " << whiteCount << "\n";
-        }
-
-        void ReturnToMenu(GameState& gameState) override {
-            gameState = MENU;
-        }
-};
-
-
 // Global game state
 GameState gameState = MENU;
      
 class Game {
        
     private:
+        // Stop any move in progress, then free both players
+        void DeletePlayers() {
+            if (blackPlayer) blackPlayer->CancelMove();
+            if (whitePlayer) whitePlayer->CancelMove();
+            delete blackPlayer;
+            delete whitePlayer;
+            blackPlayer = nullptr;
+            whitePlayer = nullptr;
+        }
+
         void SaveScore(int blackCount, int whiteCount) {
             try {
-                ofstream file("scores.txt", ios::app); // Append mode
-                if (!file) throw  runtime_error("Failed to open scores file");
+                ScoreRecord record;
+                memset(&record, 0, sizeof record);
 
                 // Get current timestamp
                 time_t now = time(nullptr);
                 if (now == -1) throw runtime_error("Failed to get time");
-                    tm* tm =  localtime(&now);
-                if (!tm) throw runtime_error("Failed to convert time");
-                
-                char timeStr[80];
-                strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", tm);
-
-                // Write score entry
-                file << "[" << timeStr << "] Black: " << blackCount 
-                        << " | White: " << whiteCount << " | Winner: ";
-                        
-                switch (result) {
-                    case BLACK_WINS: file << "Black"; break;
-                    case WHITE_WINS: file << "White"; break;
-                    case DRAW:       file << "Draw";  break;
-                    default:         file << "None";  break;
-                }
-                file << "\n";
+
+                record.time = now;
+                record.black = (uint8_t)blackCount;
+                record.white = (uint8_t)whiteCount;
+                record.result = (uint8_t)result;
+                record.mode = vsAI ? MODE_VS_AI : MODE_TWO_PLAYERS;
+                scores.Append(record);
 
             } catch (const  exception& e) {
                     cerr << "Score save error: " << e.what() << "\n";
             }
         }
 
+        // Log the finished game's moves, one block per game so none is lost on exit
+        void SaveGame(int blackCount, int whiteCount) {
+            if (!gameLog) return;
+            try {
+                gameLog->Append(moves, blackCount, whiteCount, vsAI ? SOURCE_VS_AI : SOURCE_TWO_PLAYERS, (int64_t)time(nullptr));
+                gameLog->Flush();
+            } catch (const exception& e) {
+                cerr << "Game log error: " << e.what() << "\n";
+            }
+        }
+
     public:
         Board board;                    // Game board
         bool vsAI = false;              // Playing against AI?
@@ -396,21 +289,43 @@ class Game {
         Player* blackPlayer = nullptr;  // Player 1 (Black)
         Player* whitePlayer = nullptr;  // Player 2 or AI (White)
 
-        double aiStartTime = 0;     // Timer for AI moves
-        bool aiThinking = false;    // Is AI thinking?
-        const double aiDelay = 3.0; // Delay before AI moves (seconds)
+        AISettings aiSettings;          // AI strength (3 s per move on every core by default)
+        ScoreStore scores;              // Finished games, read once at startup
+        unique_ptr<GameWriter> gameLog; // Move lists of finished games (null if the file can't be opened)
+        vector<uint8_t> moves;          // Moves of the current game, passes as MOVE_PASS
+
+        LiveAnalysis analysis;          // Background scores of the legal moves
+        bool showAnalysis = false;      // Draw them on the board (toggled with H or the Hints button)
+        vector<MoveAnalysis> hints;     // Last copy of the analysis results
+        uint64_t hintsVersion = ~0ULL;  // Analysis version that copy was taken at
 
         // Constructor
-        Game() : board() {}
+        Game() : board() {
+            try {
+                scores.Open(SCORES_FILE, LEGACY_SCORES_FILE);
+            } catch (const exception& e) {
+                cerr << "Score history error: " << e.what() << "\n";
+            }
+            try {
+                gameLog.reset(new GameWriter(GAMES_FILE));
+            } catch (const exception& e) {
+                cerr << "Game log error: " << e.what() << "\n";
+            }
+        }
+
+        // The side to move is working out its move without needing input (the AI searching)
+        bool WaitingForAI() const {
+            Player* currentPlayer = (board.currentPlayer == Black_Disc) ? blackPlayer : whitePlayer;
+            return !gameOver && currentPlayer && currentPlayer->MovePending();
+        }
         
         // Initialize players based on game mode
         void InitPlayers(bool vsAI_mode) {
             vsAI = vsAI_mode;
-            delete blackPlayer;
-            delete whitePlayer;
+            DeletePlayers();
     
             blackPlayer = new HumanPlayer();
-            whitePlayer = vsAI_mode ? (Player*) new AIPlayer() : (Player*) new HumanPlayer();
+            whitePlayer = vsAI_mode ? (Player*) new AIPlayer(aiSettings) : (Player*) new HumanPlayer();
         }
     
         // Handle player input
@@ -419,26 +334,61 @@ class Game {
 
             Player* currentPlayer = (board.currentPlayer == Black_Disc) ? blackPlayer : whitePlayer;
 
-            // AI turn handling
-            if (vsAI && board.currentPlayer == White_Disc) {
-                if (!aiThinking) {
-                    aiThinking = true;
-                    aiStartTime = GetTime();  // Start AI delay timer
-                } else if (GetTime() - aiStartTime >= aiDelay) {
-                    currentPlayer->MakeMove(board, result, gameOver);
-                    aiThinking = false; // Reset the flag after the move
-                    CheckGameOver();
-                }
-            }
-            // Human turn handling
-            else {
-                currentPlayer->MakeMove(board, result, gameOver);
-                CheckGameOver();
+            // Humans move on a click; the AI thinks on a background thread and
+            // moves once its search is done, so neither ever blocks the frame
+            int move = currentPlayer->ChooseMove(board);
+            if (move >= 0) {
+                board.PlacePiece(move % BOARD_SIZE, move / BOARD_SIZE);
+                moves.push_back((uint8_t)move);
             }
+            CheckGameOver();
         }
         
+        // Analyse the position while hints are on and it is a human's turn; copy
+        // the results only when they changed
+        void UpdateAnalysis() {
+            bool humanTurn = !vsAI || board.currentPlayer == Black_Disc;
+            if (showAnalysis && !gameOver && humanTurn && board.legalMoves) analysis.SetPosition(board);
+            else analysis.Stop();
+            if (analysis.Version() != hintsVersion) hints = analysis.Results(&hintsVersion);
+        }
+
+        // Turn the hints on or off, starting or stopping the analysis right away
+        void ToggleHints() {
+            showAnalysis = !showAnalysis;
+            UpdateAnalysis();
+        }
+
+        // Hints are still being refined
+        bool AnalysisRunning() const {
+            return showAnalysis && analysis.Running();
+        }
+
+        // The analysis has results not drawn yet
+        bool HintsChanged() const {
+            return analysis.Version() != hintsVersion;
+        }
+
+        // Score and depth of each analysed move on its cell, the best one in gold
+        void DrawHints() {
+            int best = -INF_SCORE;
+            for (const MoveAnalysis& h : hints)
+                if (h.depth > 0) best = max(best, h.score);
+            for (const MoveAnalysis& h : hints) {
+                if (h.depth == 0) continue;
+                int x = (h.move % BOARD_SIZE) * CELL_SIZE, y = (h.move / BOARD_SIZE) * CELL_SIZE;
+                string score = ScoreText(h.score);
+                const char* depth = h.exact ? "exact" : TextFormat("d%d", h.depth);
+                Color color = h.score == best ? GOLD : RAYWHITE;
+                DrawText(score.c_str(), x + (CELL_SIZE - MeasureText(score.c_str(), 20)) / 2, y + 18, 20, color);
+                DrawText(depth, x + (CELL_SIZE - MeasureText(depth, 14)) / 2, y + 48, 14, color);
+            }
+        }
+
         // Draw the game
         void Draw() {
+            if (IsKeyPressed(KEY_H)) ToggleHints();
+            else UpdateAnalysis();
             board.UpdateAnimations();
             // Determine if we should show highlights
             bool showHighlights = true;
@@ -447,6 +397,7 @@ class Game {
                 showHighlights = (board.currentPlayer == Black_Disc);
             }
             board.DrawBoard(showHighlights);
+            if (showAnalysis) DrawHints();
 
                 // Navigation buttons
                 if (DrawSmallButton({ 10, 10, 150, 30 }, "Back to Menu")) {
@@ -459,14 +410,12 @@ class Game {
                     return;
                 }
 
+                if (DrawSmallButton({SCREEN_WIDTH - 110, SCREEN_HEIGHT - 40, 100, 30 }, showAnalysis ? "Hints: on" : "Hints: off", 18))
+                    ToggleHints();
+
             // Disc counters
-            int blackCount = 0, whiteCount = 0;
-            for (int y = 0; y < BOARD_SIZE; y++) {
-                for (int x = 0; x < BOARD_SIZE; x++) {
-                    if (board.board[y][x] == Black_Disc) blackCount++;
-                    else if (board.board[y][x] == White_Disc) whiteCount++;
-                }
-            }
+            int blackCount = board.blackCount;
+            int whiteCount = board.whiteCount;
 
             // Display the score (black and white counts)
             DrawText(TextFormat("Black: %d | White: %d", blackCount, whiteCount), 10, SCREEN_HEIGHT - 30, 20, GOLD);  
@@ -513,96 +462,127 @@ class Game {
 
         // Check if game should end
         void CheckGameOver() {
-            int blackCount = 0, whiteCount = 0;
-            bool blackCanMove = false, whiteCanMove = false;
-        
-            // Count pieces and check possible moves
-            for (int y = 0; y < BOARD_SIZE; y++) {
-                for (int x = 0; x < BOARD_SIZE; x++) {
-                    if (board.board[y][x] == Black_Disc) blackCount++;
-                    else if (board.board[y][x] == White_Disc) whiteCount++;
-        
-                    if (board.board[y][x] == EMPTY) {
-                        if (!blackCanMove) {
-                            Cell temp = board.currentPlayer;
-                            board.currentPlayer = Black_Disc;
-                            if (board.CanPlace(x, y, false)) blackCanMove = true;
-                            board.currentPlayer = temp;
-                        }
-        
-                        if (!whiteCanMove) {
-                            Cell temp = board.currentPlayer;
-                            board.currentPlayer = White_Disc;
-                            if (board.CanPlace(x, y, false)) whiteCanMove = true;
-                            board.currentPlayer = temp;
-                        }
-                    }
-                }
-            }
-            
             // Determine game outcome
-            if (!blackCanMove && !whiteCanMove) {
+            if (board.noMovesLeft) {
                 gameOver = true;
-                if (blackCount > whiteCount) result = BLACK_WINS;
-                else if (whiteCount > blackCount) result = WHITE_WINS;
-                else result = DRAW;
-                SaveScore(blackCount, whiteCount);
+                blackPlayer->CancelMove();      // Nothing left to ponder
+                whitePlayer->CancelMove();
+                result = board.Result();
+                SaveScore(board.blackCount, board.whiteCount);
+                SaveGame(board.blackCount, board.whiteCount);
             }
             // Skip turn if current player can't move
-            else if ((board.currentPlayer == Black_Disc && !blackCanMove) ||
-                    (board.currentPlayer == White_Disc && !whiteCanMove)) {
-                // Skip turn
-                board.currentPlayer = (board.currentPlayer == Black_Disc) ? White_Disc : Black_Disc;
+            else if (board.legalMoves == 0) {
+                board.Pass();
+                moves.push_back(MOVE_PASS);
             }
         }
                     
         // Reset to main menu
         void ResetToMenu(GameState& gameState) {
             board = Board();
+            moves.clear();
+            analysis.Stop();
             gameOver = false;
             result = NONE;
-            delete blackPlayer;
-            delete whitePlayer;
-            blackPlayer = nullptr;
-            whitePlayer = nullptr;
+            DeletePlayers();    // Cancels a running AI search
             gameState = MENU;
-            aiThinking = false;
         }
 
         // Reset game while keeping mode
         void ResetGame() {
             board = Board();  // Create fresh board
+            moves.clear();
+            analysis.Stop();
             gameOver = false;
             result = NONE;
-            aiThinking = false;
             
             // Keep the same game mode (vsAI or two players)
             bool currentMode = vsAI;
-            delete blackPlayer;
-            delete whitePlayer;
+            DeletePlayers();    // Cancels a running AI search
             blackPlayer = new HumanPlayer();
-            whitePlayer = currentMode ? (Player*) new AIPlayer() : (Player*) new HumanPlayer();
+            whitePlayer = currentMode ? (Player*) new AIPlayer(aiSettings) : (Player*) new HumanPlayer();
         }
 
         // Destructor
         ~Game() {
-            delete blackPlayer;
-            delete whitePlayer;
+            DeletePlayers();
         }
     };
 
 // Main game loop
-int main() {
+// By default frames are event-driven: a frame is drawn when input arrives, while
+// a flip animation runs, when the screen or position changed during the last
+// frame, when the AI has its move and when the move hints have new scores;
+// otherwise the loop sleeps in the window event wait. "--continuous" redraws at 60 FPS as before.
+// "--trace FILE" writes the AI's search timeline for chrome://tracing (profiling builds).
+// "--ponder" lets the AI think on the player's time; off by default, since that keeps
+// every core busy while the player thinks.
+int main(int argc, char** argv) {
+
+    bool eventDriven = true;
+    bool ponder = false;
+    unique_ptr<TraceFile> trace;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--continuous") eventDriven = false;
+        else if (arg == "--ponder") ponder = true;
+        else if (arg == "--trace" && i + 1 < argc) {
+            try {
+                trace.reset(new TraceFile(argv[++i]));
+                if (!PROFILING) cerr << "Built without OTHELLO_PROFILE: the trace will stay empty\n";
+            } catch (const exception& e) {
+                cerr << e.what() << " - not tracing\n";
+            }
+        }
+    }
+    bool redraw = true;         // Something changed on the last frame: draw the next one right away
+    size_t historyOffset = 0;   // Newest games skipped on the score history screen
 
     // Initialize window
     
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Othello");
     SetTargetFPS(60);
+
+    // Use trained evaluation weights when present, the built-in ones otherwise
+    if (ifstream(WEIGHTS_FILE)) {
+        try {
+            EvalWeights::Active() = EvalWeights::Load(WEIGHTS_FILE);
+            cout << "Loaded evaluation weights from " << WEIGHTS_FILE << "\n";
+        } catch (const exception& e) {
+            cerr << e.what() << " - using the built-in weights\n";
+        }
+    }
     
+    // The opening book is mapped, not read, so opening it costs nothing
+    OpeningBook book;
+    if (ifstream(BOOK_FILE)) {
+        try {
+            book.Open(BOOK_FILE);
+            cout << "Opened opening book " << BOOK_FILE << " (" << book.Size() << " positions)\n";
+        } catch (const exception& e) {
+            cerr << e.what() << " - playing without a book\n";
+        }
+    }
+
     Game game;
+    if (book.IsOpen()) game.aiSettings.book = &book;
+    game.aiSettings.trace = trace.get();
+    if (ponder) game.aiSettings.ponder = PONDER_PREDICTED;
 
     while (!WindowShouldClose()) 
     {
+        // While the AI thinks or the hints are refined and nothing moves, poll for
+        // input, the AI's move or new hint scores without drawing
+        if (eventDriven && !redraw && gameState == GAMEPLAY && (game.WaitingForAI() || game.AnalysisRunning())) {
+            WaitTime(1.0 / 60);
+            PollInputEvents();
+            if (!InputArrived() && !game.HintsChanged()) continue;
+        }
+        GameState shownState = gameState;
+        uint64_t shownPosition = game.board.hash;
+        size_t shownOffset = historyOffset;
+
         BeginDrawing();
         ClearBackground(BLACK);
 
@@ -619,8 +599,10 @@ int main() {
             if (DrawButton({ 250, 270, 150, 50 }, "How to Play"))
                 gameState = HOW_TO_PLAY;
 
-            if (DrawButton({ 250, 340, 150, 50 }, "Scores")) 
+            if (DrawButton({ 250, 340, 150, 50 }, "Scores")) {
                 gameState = SCORE_HISTORY;
+                historyOffset = 0;
+            }
 
             if (DrawButton({ 250, 410, 150, 50 }, "Exit"))
                 break;
@@ -672,18 +654,32 @@ int main() {
         else if (gameState == SCORE_HISTORY) {
             DrawText("Score History", 220, 70, 30, DARKBLUE);
 
-            ifstream file("scores.txt");
-            int yPos = 120;
-            char line[256];
-            
-            if (!file) {
+            // Everything comes from the in-memory index; no file is read per frame
+            const ScoreStore& scores = game.scores;
+            if (scores.Size() == 0) {
                 DrawText("No scores recorded yet!", 200, 200, 19, WHITE);
             } else {
-                while (file.getline(line, sizeof(line))) {
-                    if (yPos > SCREEN_HEIGHT - 50) break;
-                    DrawText(line, 60, yPos, 19, WHITE);
+                ScoreSummary all = scores.Summary();
+                time_t now = time(nullptr);
+                ScoreSummary week = scores.Summary(now - 7 * 24 * 3600, now + 1);
+                DrawText(TextFormat("All: %d games | Black %.0f%% | White %.0f%% | Avg %.1f-%.1f",
+                                    (int)all.games, 100 * all.BlackWinRate(), 100 * all.WhiteWinRate(),
+                                    all.AverageBlack(), all.AverageWhite()), 60, 110, 19, GOLD);
+                DrawText(TextFormat("Last 7 days: %d games | Black %.0f%% | White %.0f%%",
+                                    (int)week.games, 100 * week.BlackWinRate(), 100 * week.WhiteWinRate()), 60, 135, 19, GOLD);
+
+                int yPos = 170;
+                for (const ScoreRecord& r : scores.Page(historyOffset, SCORES_PER_PAGE)) {
+                    DrawText(ScoreStore::Format(r).c_str(), 60, yPos, 19, WHITE);
                     yPos += 30;
                 }
+
+                // Paging
+                if (historyOffset > 0 && DrawSmallButton({ 60, SCREEN_HEIGHT - 70, 100, 30 }, "Newer"))
+                    historyOffset -= SCORES_PER_PAGE;
+                if (historyOffset + SCORES_PER_PAGE < scores.Size() &&
+                    DrawSmallButton({ SCREEN_WIDTH - 160, SCREEN_HEIGHT - 70, 100, 30 }, "Older"))
+                    historyOffset += SCORES_PER_PAGE;
             }
             
             if (DrawButton({ 250, SCREEN_HEIGHT - 80, 150, 50 }, "Back")) {
@@ -696,6 +692,15 @@ int main() {
             game.HandleInput();
             game.Draw();
         }
+
+        // Start the next frame right away while the screen is changing; keep polling
+        // while the AI thinks; otherwise EndDrawing blocks until the next input event
+        if (eventDriven) {
+            redraw = gameState != shownState || game.board.hash != shownPosition || historyOffset != shownOffset
+                  || game.board.IsAnimating();
+            if (redraw || (gameState == GAMEPLAY && (game.WaitingForAI() || game.AnalysisRunning()))) DisableEventWaiting();
+            else EnableEventWaiting();
+        }
         EndDrawing();
     }
 
@@ -0,0 +1,266 @@
+// Players - the interface the game loop drives, and the engine-backed AIPlayer
+#ifndef OTHELLO_PLAYER_H
+#define OTHELLO_PLAYER_H
+
+#include "search.h"
+#include "book.h"
+#include <iostream>     // For console output
+#include <memory>       // For unique_ptr
+#include <vector>       // For the search threads
+#include <thread>       // For the parallel search helpers
+#include <future>       // For running the AI search in the background
+#include <atomic>       // For cancelling the background search
+
+// Player interface - asked for a move over and over until it has one
+class Player {
+    public:
+        // Square to play in pos, or -1 while the player is still deciding
+        virtual int ChooseMove(const Position& pos) = 0;
+        virtual void ShowScore(int blackCount, int whiteCount) = 0;
+        virtual void CancelMove() {}    // Abandon any move still being worked out
+        virtual bool MovePending() const { return false; }  // Working on a move that needs no input
+        virtual ~Player() {}
+    };
+
+// What the AI searches while the opponent thinks about its reply
+enum PonderMode {
+    PONDER_OFF,
+    PONDER_PREDICTED,   // The position after the reply its own PV expects
+    PONDER_ALL,         // The position after its own move, which fills the table for every reply
+};
+
+// Engine settings for one AI player
+struct AISettings {
+    double thinkTime = 3.0;             // Wall-clock budget per move (seconds)
+    int maxDepth = MAX_PLY;             // Deepest iteration (for fixed-depth play)
+    int threads = 0;                    // Search threads, 0 = one per hardware core
+    size_t ttSizeMB = TT_SIZE_MB;       // Transposition table size
+    int solveEmpties = SOLVE_EMPTIES;   // Switch to the exact endgame solver at this many empties
+    const EvalWeights* weights = nullptr;   // Evaluation weights, nullptr = EvalWeights::Active()
+    bool canonicalTT = false;           // Share table entries between symmetric positions
+    const OpeningBook* book = nullptr;      // Played without searching when it has the position
+    PonderMode ponder = PONDER_OFF;     // Keep searching on the opponent's time (ChooseMove only)
+    TranspositionTable* sharedTT = nullptr; // Use this table, shared with other players, instead of an
+                                            // own one of ttSizeMB; its owner ages it (NewSearch)
+    TraceFile* trace = nullptr;         // Write every search's timed spans here (when PROFILING)
+};
+
+// AI player implementation
+class AIPlayer : public Player {
+    private:
+        AISettings settings;
+        std::unique_ptr<TranspositionTable> ownTT;     // Unless settings.sharedTT is given
+        TranspositionTable* tt;     // Results of earlier searches, kept across moves
+        int threadCount;            // Search threads (main + Lazy SMP helpers)
+
+        SearchShared shared;
+        std::vector<std::unique_ptr<SearchThread>> threads;    // threads[0] is the main thread
+        SearchStats lastStats;
+
+        // Background search
+        std::future<int> pending;           // Best square (or -1) of the running search
+        uint64_t pendingHash = 0;           // Position the running search was started on
+        std::atomic<bool> cancelled{false}; // Set by the UI thread to abort the search
+        bool pondering = false;             // The running search is on the opponent's time
+        bool ponderHit = false;             // The running search began as a ponder search
+
+    public:
+        explicit AIPlayer(const AISettings& settings = AISettings())
+            : settings(settings), ownTT(settings.sharedTT ? nullptr : new TranspositionTable(settings.ttSizeMB)),
+              tt(settings.sharedTT ? settings.sharedTT : ownTT.get()) {
+            threadCount = settings.threads > 0 ? settings.threads : std::max(1, (int)std::thread::hardware_concurrency());
+            shared.tt = tt;
+            shared.cancelled = &cancelled;
+            shared.maxDepth = settings.maxDepth;
+            shared.canonicalKeys = settings.canonicalTT;
+            for (int i = 0; i < threadCount; i++)
+                threads.emplace_back(new SearchThread(shared, i == 0, settings.weights ? *settings.weights : EvalWeights::Active()));
+        }
+
+        ~AIPlayer() {
+            CancelMove();
+        }
+
+        const AISettings& Settings() const {
+            return settings;
+        }
+
+        const SearchStats& LastStats() const {
+            return lastStats;
+        }
+
+        // Use a new time budget per move from the next search on
+        void SetThinkTime(double seconds) {
+            settings.thinkTime = seconds;
+        }
+
+        // Forget everything learned from earlier searches (e.g. before a new game);
+        // a shared table is left alone, other players still use it
+        void NewGame() {
+            if (ownTT) ownTT->Clear();
+            for (auto& t : threads) t->ClearHistory();
+        }
+
+        // Iterative deepening within the thinking budget on all threads; returns the
+        // best move of the deepest completed iteration, or -1 if there is no legal move
+        int Search(const Position& pos) {
+            uint64_t moves = pos.LegalMoves();
+            if (moves == 0) return -1;
+
+            Clock::time_point start = Clock::now();
+            if (settings.book) {
+                int score;
+                int bookMove = settings.book->Probe(pos, &score);
+                if (bookMove >= 0) {
+                    lastStats = SearchStats();
+                    lastStats.fromBook = true;
+                    lastStats.move = bookMove;
+                    lastStats.pv.assign(1, bookMove);
+                    lastStats.score = score;
+                    lastStats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                    return bookMove;
+                }
+            }
+
+            shared.start = start;
+            shared.deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(settings.thinkTime));
+            shared.stop = false;
+            if (ownTT) ownTT->NewSearch();
+
+            // The endgame solver runs on the main thread alone
+            bool solving = PopCount(pos.bits.Empty()) <= settings.solveEmpties;
+            std::vector<std::thread> helpers;
+            for (int i = 1; i < threadCount && !solving; i++)
+                helpers.emplace_back([this, i, &pos]() { threads[i]->Run(pos, i & 1, 0); });
+            threads[0]->Run(pos, 0, settings.solveEmpties);
+            for (std::thread& t : helpers) t.join();
+
+            // Take the deepest completed result; the main thread wins ties
+            const SearchThread* best = threads[0].get();
+            lastStats = SearchStats();
+            for (int i = 0; i < (solving ? 1 : threadCount); i++) {
+                const SearchThread* t = threads[i].get();
+                lastStats.nodes += t->nodes;
+                lastStats.counters.Add(t->counters);
+                if (PROFILING) {
+                    lastStats.profile.Add(t->profile);
+                    lastStats.threadProfiles.push_back(t->profile);
+                }
+                if (t->completedDepth > best->completedDepth && t->bestRootMove != NO_MOVE) best = t;
+            }
+            lastStats.depth = best->completedDepth;
+            lastStats.score = best->bestRootScore;
+            lastStats.wldOnly = best->bestRootWLD;
+            lastStats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            lastStats.threads = solving ? 1 : threadCount;
+            lastStats.iterations = threads[0]->iterations;
+            lastStats.move = best->bestRootMove != NO_MOVE ? best->bestRootMove : LowestBit(moves);
+            lastStats.pv = best->pv;
+            if (lastStats.pv.empty() || lastStats.pv[0] != lastStats.move) lastStats.pv.assign(1, lastStats.move);
+
+            if (PROFILING && settings.trace) {
+                std::string label = SquareName(lastStats.move) + " at " + std::to_string(PopCount(pos.bits.Empty())) + " empties";
+                for (const SearchProfile& p : lastStats.threadProfiles) settings.trace->Write(p, label);
+            }
+            return lastStats.move;
+        }
+
+        // Launch a search of pos on a worker thread
+        void StartSearch(const Position& pos) {
+            cancelled = false;
+            pendingHash = pos.hash;
+            pending = std::async(std::launch::async, [this, pos]() { return Search(pos); });
+        }
+
+        // After playing move in pos, search on while the opponent thinks: the position
+        // its predicted reply leads to, or with PONDER_ALL the one it has to reply in
+        void StartPonder(const Position& pos, int move) {
+            Position next = pos;
+            next.MakeMove(move);
+            if (settings.ponder == PONDER_PREDICTED) {
+                if (next.LegalMoves() == 0) {
+                    next.Pass();    // Forced: the opponent can only pass
+                } else {
+                    const std::vector<int>& pv = lastStats.pv;
+                    if (pv.size() < 2 || pv[0] != move || pv[1] >= 64 || !(next.LegalMoves() & (1ULL << pv[1]))) return;
+                    next.MakeMove(pv[1]);
+                }
+            }
+            if (next.IsGameOver()) return;
+            shared.pondering = true;
+            pondering = true;
+            StartSearch(next);
+        }
+
+        // The opponent's move led to the position being pondered: let the search
+        // run on as this move's search, its clock starting now
+        void PonderHit() {
+            pondering = false;
+            ponderHit = true;
+            shared.pondering = false;
+        }
+
+        bool IsThinking() const {
+            return pending.valid();
+        }
+
+        // Non-blocking check for a finished background search
+        bool SearchFinished() const {
+            return pending.valid() && pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        // A ponder search waits on the opponent, not the other way round
+        bool MovePending() const override {
+            return IsThinking() && !SearchFinished() && !pondering;
+        }
+
+        // Called every frame on the AI's turn: starts the search on the first call and
+        // returns the move once it is ready, so the render loop never waits on it.
+        // A ponder search of this very position is taken over instead; one of any
+        // other position is stopped, leaving its table entries behind.
+        int ChooseMove(const Position& pos) override {
+            if (pondering) {
+                if (pos.hash == pendingHash) PonderHit();
+                else CancelMove();
+            }
+            if (!IsThinking()) {
+                StartSearch(pos);
+                return -1;
+            }
+            if (!SearchFinished()) return -1;
+
+            int bestMove = pending.get();
+            bool hit = ponderHit;
+            ponderHit = false;
+            if (pos.hash != pendingHash) return -1;    // Position changed meanwhile; search again
+
+            if (bestMove != -1 && lastStats.fromBook) {
+                std::cout << "AI: book move " << SquareName(bestMove) << "\n";
+            } else if (bestMove != -1) {
+                std::cout << "AI: depth " << lastStats.depth << ", " << lastStats.nodes << " nodes, "
+                          << (uint64_t)lastStats.NodesPerSecond() << " nodes/s on " << lastStats.threads << " threads"
+                          << (hit ? " (ponder hit)" : "") << "\n" << ProfileReport(lastStats);
+            } else {
+                std::cout << "AI has no valid moves. Passing...\n";
+            }
+            if (bestMove != -1 && settings.ponder != PONDER_OFF) StartPonder(pos, bestMove);
+            return bestMove;
+        }
+
+        // Stop the background search (pondering included) and wait for the worker to exit
+        void CancelMove() override {
+            pondering = false;
+            ponderHit = false;
+            shared.pondering = false;
+            if (!pending.valid()) return;
+            cancelled = true;
+            pending.wait();
+            pending = std::future<int>();
+        }
+
+        void ShowScore(int blackCount, int whiteCount) override {
+            std::cout << "AI Score - Black: " << blackCount << " | White: " << whiteCount << "\n";
+        }
+};
+
+#endif
@@ -0,0 +1,157 @@
+// Game rules on top of the bitboards - Position with side to move and Zobrist key
+#ifndef OTHELLO_POSITION_H
+#define OTHELLO_POSITION_H
+
+#include "bitboard.h"
+#include <string>       // For move notation
+
+enum GameResult { NONE, BLACK_WINS, WHITE_WINS, DRAW }; // Game outcomes
+
+// Zobrist keys, generated at compile time with splitmix64
+constexpr uint64_t SplitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+struct ZobristKeys {
+    uint64_t black[64];     // Black disc on square
+    uint64_t white[64];     // White disc on square
+    uint64_t flip[64];      // Disc on square changes colour (black ^ white)
+    uint64_t side;          // White to move
+
+    constexpr ZobristKeys() : black{}, white{}, flip{}, side(0) {
+        uint64_t state = 0x0DDBA11;
+        for (int sq = 0; sq < 64; sq++) {
+            black[sq] = SplitMix64(state);
+            white[sq] = SplitMix64(state);
+            flip[sq] = black[sq] ^ white[sq];
+        }
+        side = SplitMix64(state);
+    }
+};
+
+static constexpr ZobristKeys ZOBRIST{};
+
+// Search position - discs and side to move only, cheap to copy and updated in place
+struct Position {
+    BitBoard bits;                          // Disc masks for both colours
+    Cell currentPlayer = Black_Disc;        // Side to move
+    uint64_t hash = 0;                      // Zobrist key, kept up to date by every move
+
+    Position() {
+        Reset();
+    }
+
+    // Starting position with Black to move
+    void Reset() {
+        bits.white = SquareBit(3, 3) | SquareBit(4, 4);
+        bits.black = SquareBit(3, 4) | SquareBit(4, 3);
+        currentPlayer = Black_Disc;
+        hash = ComputeHash();
+    }
+
+    // Full Zobrist key from scratch (the incremental one must always match it)
+    uint64_t ComputeHash() const {
+        uint64_t h = (currentPlayer == White_Disc) ? ZOBRIST.side : 0;
+        for (uint64_t b = bits.black; b; b &= b - 1) h ^= ZOBRIST.black[LowestBit(b)];
+        for (uint64_t w = bits.white; w; w &= w - 1) h ^= ZOBRIST.white[LowestBit(w)];
+        return h;
+    }
+
+    uint64_t LegalMoves() const { return bits.LegalMoves(currentPlayer); }
+
+    // Play a legal move for the side to move; returns the flipped discs for UndoMove
+    uint64_t MakeMove(int sq) {
+        uint64_t flips = bits.Flips(currentPlayer, sq);
+        bits.Apply(currentPlayer, sq, flips);
+        UpdateHash(sq, flips);
+        currentPlayer = Opponent(currentPlayer);
+        return flips;
+    }
+
+    void UndoMove(int sq, uint64_t flips) {
+        currentPlayer = Opponent(currentPlayer);
+        bits.Revert(currentPlayer, sq, flips);
+        UpdateHash(sq, flips);
+    }
+
+    // Hand the turn to the other side (its own inverse)
+    void Pass() {
+        currentPlayer = Opponent(currentPlayer);
+        hash ^= ZOBRIST.side;
+    }
+
+    // Neither side can move
+    bool IsGameOver() const {
+        return LegalMoves() == 0 && bits.LegalMoves(Opponent(currentPlayer)) == 0;
+    }
+
+    // Winner by disc count (final once the game is over)
+    GameResult Result() const {
+        int black = PopCount(bits.black), white = PopCount(bits.white);
+        return black > white ? BLACK_WINS : white > black ? WHITE_WINS : DRAW;
+    }
+
+    private:
+        // XOR in/out a move by currentPlayer on sq with its flips, and the side change
+        void UpdateHash(int sq, uint64_t flips) {
+            hash ^= ZOBRIST.side ^ (currentPlayer == Black_Disc ? ZOBRIST.black[sq] : ZOBRIST.white[sq]);
+            for (; flips; flips &= flips - 1) hash ^= ZOBRIST.flip[LowestBit(flips)];
+        }
+};
+
+// Move notation: column letter a-h and row number 1-8, e.g. "f5"
+inline std::string SquareName(int sq) {
+    if (sq < 0 || sq >= 64) return "pass";
+    return std::string(1, (char)('a' + sq % BOARD_SIZE)) + (char)('1' + sq / BOARD_SIZE);
+}
+
+// Square index of a move such as "f5" or "F5"; -1 if it is not a square
+inline int ParseSquare(const std::string& text) {
+    if (text.size() < 2) return -1;
+    int col = (text[0] | 0x20) - 'a';
+    int row = text[1] - '1';
+    if (col < 0 || col >= BOARD_SIZE || row < 0 || row >= BOARD_SIZE) return -1;
+    return row * BOARD_SIZE + col;
+}
+
+// Board notation: 64 cells row by row from a1 ('X' black, 'O' white, '-' or '.' empty),
+// then the side to move ('X' or 'O'); whitespace is ignored
+inline bool ParseBoard(const std::string& text, Position& pos) {
+    Position parsed;
+    parsed.bits.black = parsed.bits.white = 0;
+    int cells = 0;
+    bool sideSeen = false;
+    for (char c : text) {
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+        char u = (char)(c & ~0x20);     // Upper case
+        if (cells < 64) {
+            if (u == 'X' || c == '*') parsed.bits.black |= 1ULL << cells;
+            else if (u == 'O') parsed.bits.white |= 1ULL << cells;
+            else if (c != '-' && c != '.') return false;
+            cells++;
+        } else if (!sideSeen && (u == 'X' || u == 'O' || c == '*')) {
+            parsed.currentPlayer = (u == 'O') ? White_Disc : Black_Disc;
+            sideSeen = true;
+        } else {
+            return false;
+        }
+    }
+    if (cells < 64 || !sideSeen) return false;
+    parsed.hash = parsed.ComputeHash();
+    pos = parsed;
+    return true;
+}
+
+inline std::string BoardString(const Position& pos) {
+    std::string text(64, '-');
+    for (int sq = 0; sq < 64; sq++) {
+        if (pos.bits.black >> sq & 1) text[sq] = 'X';
+        else if (pos.bits.white >> sq & 1) text[sq] = 'O';
+    }
+    return text + ' ' + (pos.currentPlayer == Black_Disc ? 'X' : 'O');
+}
+
+#endif
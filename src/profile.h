@@ -0,0 +1,114 @@
+// Search profiling - hot-path counters, timed spans and a chrome://tracing writer.
+// Compiled in with -DOTHELLO_PROFILE=1 (make PROFILE=1); otherwise every counter
+// update is behind a constant false condition and compiles to nothing.
+#ifndef OTHELLO_PROFILE_H
+#define OTHELLO_PROFILE_H
+
+#include <algorithm>    // For min
+#include <atomic>       // For thread ids
+#include <chrono>
+#include <cstdint>
+#include <cstdio>       // For snprintf
+#include <fstream>
+#include <mutex>        // Several engines may write one trace
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef OTHELLO_PROFILE
+#define OTHELLO_PROFILE 0
+#endif
+
+const bool PROFILING = OTHELLO_PROFILE != 0;
+const int PROFILE_CUTOFF_SLOTS = 8;     // Cutoffs by move index; the last slot counts that index and later
+
+// A timed stretch of one search thread: an iteration or a solver phase
+struct ProfileSpan {
+    const char* name;
+    int depth;
+    std::chrono::steady_clock::time_point start, end;
+    uint64_t nodes;         // Visited during the span
+    bool completed;         // False when the clock or a cancel cut it short
+};
+
+// Counters of one search thread for one search. Only updated when PROFILING.
+struct SearchProfile {
+    int thread = 0;                 // Process-wide id of the search thread, for traces
+    uint64_t nodes = 0;
+    uint64_t evals = 0;             // Leaf evaluations
+    uint64_t moveGens = 0;          // Move generations: legal moves, pass checks, mobility for
+                                    // ordering and the evaluator's mobility feature. The solver's
+                                    // last four empties test moves by flipping and are not counted.
+    uint64_t cutoffsAt[PROFILE_CUTOFF_SLOTS] = {};
+    std::vector<ProfileSpan> spans;
+
+    // Clear the counts, keeping the thread id
+    void Reset() {
+        int id = thread;
+        *this = SearchProfile();
+        thread = id;
+    }
+
+    // Sum counts (not spans) over threads
+    void Add(const SearchProfile& other) {
+        nodes += other.nodes;
+        evals += other.evals;
+        moveGens += other.moveGens;
+        for (int i = 0; i < PROFILE_CUTOFF_SLOTS; i++) cutoffsAt[i] += other.cutoffsAt[i];
+    }
+
+    void CountCutoff(int moveIndex) {
+        cutoffsAt[std::min(moveIndex, PROFILE_CUTOFF_SLOTS - 1)]++;
+    }
+};
+
+inline int NewProfileThreadId() {
+    static std::atomic<int> next{0};
+    return next++;
+}
+
+// Writes spans as complete ("X") events of the Trace Event format, which
+// chrome://tracing and Perfetto open. The array is closed by the destructor, but
+// both viewers also accept a file cut off after any event, e.g. by a crash.
+class TraceFile {
+    private:
+        std::ofstream out;
+        std::mutex mutex;
+        std::chrono::steady_clock::time_point epoch;
+        bool first = true;
+
+        double Micros(std::chrono::steady_clock::time_point t) const {
+            return std::chrono::duration<double, std::micro>(t - epoch).count();
+        }
+
+    public:
+        explicit TraceFile(const std::string& path) : out(path), epoch(std::chrono::steady_clock::now()) {
+            if (!out) throw std::runtime_error("Failed to open " + path + " for writing");
+            out << "[\n";
+        }
+
+        ~TraceFile() {
+            out << "\n]\n";
+        }
+
+        TraceFile(const TraceFile&) = delete;
+        TraceFile& operator=(const TraceFile&) = delete;
+
+        // Append the spans of one thread's search; label names the search (e.g. the move)
+        void Write(const SearchProfile& profile, const std::string& label) {
+            std::lock_guard<std::mutex> lock(mutex);
+            char line[320];
+            for (const ProfileSpan& s : profile.spans) {
+                std::snprintf(line, sizeof line,
+                    "%s{\"name\":\"%s %d\",\"cat\":\"search\",\"ph\":\"X\",\"ts\":%.1f,\"dur\":%.1f,\"pid\":1,\"tid\":%d,"
+                    "\"args\":{\"search\":\"%s\",\"nodes\":%llu,\"completed\":%s}}",
+                    first ? "" : ",\n", s.name, s.depth, Micros(s.start), Micros(s.end) - Micros(s.start), profile.thread,
+                    label.c_str(), (unsigned long long)s.nodes, s.completed ? "true" : "false");
+                out << line;
+                first = false;
+            }
+            out.flush();
+        }
+};
+
+#endif
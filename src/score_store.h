@@ -0,0 +1,253 @@
+// Score history - append-only binary log of finished games with an in-memory index
+#ifndef OTHELLO_SCORE_STORE_H
+#define OTHELLO_SCORE_STORE_H
+
+#include "position.h"
+#include <algorithm>    // For stable_sort and lower_bound
+#include <cstdio>       // For sscanf
+#include <cstring>      // For the file header
+#include <ctime>        // For game timestamps
+#include <fstream>      // For the log file
+#include <stdexcept>    // For score file errors
+#include <string>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>     // For truncate
+#endif
+
+// File layout: 16-byte header (magic, record size), then one fixed-size record
+// per game in the order the games were saved
+const char SCORE_MAGIC[8] = {'O', 'T', 'H', 'S', 'C', 'O', 'R', '1'};
+
+enum GameMode : uint8_t { MODE_UNKNOWN, MODE_TWO_PLAYERS, MODE_VS_AI };
+
+struct ScoreHeader {
+    char magic[8];
+    uint32_t recordSize;
+    uint32_t reserved;
+};
+
+struct ScoreRecord {
+    int64_t time;           // When the game ended (Unix time)
+    uint8_t black;          // Final disc counts
+    uint8_t white;
+    uint8_t result;         // GameResult
+    uint8_t mode;           // GameMode
+    uint8_t reserved[4];
+};
+static_assert(sizeof(ScoreRecord) == 16, "ScoreRecord must stay 16 bytes");
+
+// Totals over a range of games
+struct ScoreSummary {
+    size_t games = 0;
+    size_t blackWins = 0;
+    size_t whiteWins = 0;
+    size_t draws = 0;
+    uint64_t blackDiscs = 0;
+    uint64_t whiteDiscs = 0;
+
+    double BlackWinRate() const { return games ? (double)blackWins / games : 0; }
+    double WhiteWinRate() const { return games ? (double)whiteWins / games : 0; }
+    double DrawRate() const { return games ? (double)draws / games : 0; }
+    double AverageBlack() const { return games ? (double)blackDiscs / games : 0; }
+    double AverageWhite() const { return games ? (double)whiteDiscs / games : 0; }
+};
+
+// The log is read once on Open; after that every query runs on the in-memory
+// records (kept in time order) and running totals, and Append writes one record
+// to the open file and updates both.
+class ScoreStore {
+    private:
+        std::string path;
+        std::ofstream log;
+        std::vector<ScoreRecord> records;   // Sorted by time
+        std::vector<ScoreSummary> totals;   // totals[i] covers records[0, i)
+
+        void AddTotals(const ScoreRecord& r) {
+            ScoreSummary s = totals.back();
+            s.games++;
+            if (r.result == BLACK_WINS) s.blackWins++;
+            else if (r.result == WHITE_WINS) s.whiteWins++;
+            else if (r.result == DRAW) s.draws++;
+            s.blackDiscs += r.black;
+            s.whiteDiscs += r.white;
+            totals.push_back(s);
+        }
+
+        void RebuildTotals() {
+            totals.assign(1, ScoreSummary());
+            for (const ScoreRecord& r : records) AddTotals(r);
+        }
+
+        // Index of the first record at or after t
+        size_t Lower(int64_t t) const {
+            return std::lower_bound(records.begin(), records.end(), t,
+                [](const ScoreRecord& r, int64_t time) { return r.time < time; }) - records.begin();
+        }
+
+        static void WriteHeader(std::ostream& out) {
+            ScoreHeader header;
+            std::memcpy(header.magic, SCORE_MAGIC, sizeof header.magic);
+            header.recordSize = sizeof(ScoreRecord);
+            header.reserved = 0;
+            out.write(reinterpret_cast<const char*>(&header), sizeof header);
+        }
+
+        void Write(const ScoreRecord& r) {
+            log.write(reinterpret_cast<const char*>(&r), sizeof r);
+        }
+
+        // Cut a record torn by a crash off the end of the log, so later appends
+        // stay on record boundaries. records must still be in file order.
+        void DropTornRecord() {
+            std::streamoff size = sizeof(ScoreHeader) + records.size() * sizeof(ScoreRecord);
+#if defined(__unix__) || defined(__APPLE__)
+            if (truncate(path.c_str(), (off_t)size) != 0) throw std::runtime_error("Failed to truncate " + path);
+#else
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            WriteHeader(out);
+            for (const ScoreRecord& r : records) out.write(reinterpret_cast<const char*>(&r), sizeof r);
+            if (!out || out.tellp() != size) throw std::runtime_error("Failed to rewrite " + path);
+#endif
+        }
+
+    public:
+        ScoreStore() {
+            totals.assign(1, ScoreSummary());
+        }
+
+        // Load the log at path, creating it if needed. If it does not exist yet (or
+        // holds less than a header, e.g. after a crash while creating it) and
+        // legacyText names a scores.txt file, that history is imported first. A
+        // partial record at the end, left by a crash mid-append, is dropped.
+        // Throws if the file cannot be read or written.
+        void Open(const std::string& path, const std::string& legacyText = "") {
+            this->path = path;
+            records.clear();
+            log.close();
+
+            std::ifstream in(path, std::ios::binary | std::ios::ate);
+            std::streamoff size = in ? (std::streamoff)in.tellg() : 0;
+            bool empty = size < (std::streamoff)sizeof(ScoreHeader);   // Missing, or its header never finished
+            if (!empty) {
+                in.seekg(0);
+                ScoreHeader header;
+                in.read(reinterpret_cast<char*>(&header), sizeof header);
+                if (!in || std::memcmp(header.magic, SCORE_MAGIC, sizeof header.magic) != 0 || header.recordSize != sizeof(ScoreRecord))
+                    throw std::runtime_error(path + " is not a score file");
+                ScoreRecord r;
+                while (in.read(reinterpret_cast<char*>(&r), sizeof r)) records.push_back(r);
+            }
+            in.close();
+            if (empty && size > 0) std::ofstream(path, std::ios::binary | std::ios::trunc);   // Start a torn header over
+            if (!empty && (size - (std::streamoff)sizeof(ScoreHeader)) % sizeof(ScoreRecord) != 0) DropTornRecord();
+
+            log.open(path, std::ios::binary | std::ios::app);
+            if (!log) throw std::runtime_error("Failed to open " + path + " for writing");
+            if (empty) {
+                WriteHeader(log);
+                if (!legacyText.empty()) {
+                    for (const ScoreRecord& r : ReadText(legacyText)) {
+                        Write(r);
+                        records.push_back(r);
+                    }
+                }
+                log.flush();
+            }
+
+            std::stable_sort(records.begin(), records.end(),
+                [](const ScoreRecord& a, const ScoreRecord& b) { return a.time < b.time; });
+            RebuildTotals();
+        }
+
+        bool IsOpen() const { return log.is_open(); }
+
+        // Log a finished game
+        void Append(const ScoreRecord& r) {
+            if (!log.is_open()) throw std::runtime_error("Score file is not open");
+            Write(r);
+            log.flush();
+            if (!log) throw std::runtime_error("Failed to write " + path);
+
+            if (records.empty() || records.back().time <= r.time) {
+                records.push_back(r);
+                AddTotals(r);
+            } else {            // Clock went backwards: keep the index in time order
+                records.insert(records.begin() + Lower(r.time + 1), r);
+                RebuildTotals();
+            }
+        }
+
+        size_t Size() const { return records.size(); }
+
+        // Up to count records, newest first, skipping the newest `skip`
+        std::vector<ScoreRecord> Page(size_t skip, size_t count) const {
+            std::vector<ScoreRecord> page;
+            for (size_t i = skip; i < records.size() && page.size() < count; i++)
+                page.push_back(records[records.size() - 1 - i]);
+            return page;
+        }
+
+        // Totals over all games
+        ScoreSummary Summary() const {
+            return totals.back();
+        }
+
+        // Totals over the games that ended in [from, to)
+        ScoreSummary Summary(int64_t from, int64_t to) const {
+            size_t a = Lower(from), b = std::max(a, Lower(to));
+            ScoreSummary s;
+            const ScoreSummary &lo = totals[a], &hi = totals[b];
+            s.games = hi.games - lo.games;
+            s.blackWins = hi.blackWins - lo.blackWins;
+            s.whiteWins = hi.whiteWins - lo.whiteWins;
+            s.draws = hi.draws - lo.draws;
+            s.blackDiscs = hi.blackDiscs - lo.blackDiscs;
+            s.whiteDiscs = hi.whiteDiscs - lo.whiteDiscs;
+            return s;
+        }
+
+        // Records of the old text format, "[YYYY-MM-DD HH:MM:SS] Black: N | White: M | Winner: X"
+        // per line; lines that do not parse are skipped
+        static std::vector<ScoreRecord> ReadText(const std::string& path) {
+            std::vector<ScoreRecord> out;
+            std::ifstream in(path);
+            std::string line;
+            while (std::getline(in, line)) {
+                std::tm tm = {};
+                int black, white;
+                char winner[16];
+                if (std::sscanf(line.c_str(), "[%d-%d-%d %d:%d:%d] Black: %d | White: %d | Winner: %15s",
+                                &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec,
+                                &black, &white, winner) != 9)
+                    continue;
+                tm.tm_year -= 1900;
+                tm.tm_mon -= 1;
+                tm.tm_isdst = -1;
+
+                ScoreRecord r;
+                std::memset(&r, 0, sizeof r);
+                r.time = (int64_t)std::mktime(&tm);
+                r.black = (uint8_t)black;
+                r.white = (uint8_t)white;
+                std::string w = winner;
+                r.result = w == "Black" ? BLACK_WINS : w == "White" ? WHITE_WINS : w == "Draw" ? DRAW : NONE;
+                r.mode = MODE_UNKNOWN;
+                out.push_back(r);
+            }
+            return out;
+        }
+
+        // One record in the old text format, in local time
+        static std::string Format(const ScoreRecord& r) {
+            std::time_t t = (std::time_t)r.time;
+            char timeStr[32] = "unknown time";
+            if (std::tm* tm = std::localtime(&t)) std::strftime(timeStr, sizeof timeStr, "%Y-%m-%d %H:%M:%S", tm);
+            const char* winner = r.result == BLACK_WINS ? "Black" : r.result == WHITE_WINS ? "White"
+                               : r.result == DRAW ? "Draw" : "None";
+            return std::string("[") + timeStr + "] Black: " + std::to_string(r.black) + " | White: "
+                 + std::to_string(r.white) + " | Winner: " + winner;
+        }
+};
+
+#endif
@@ -0,0 +1,852 @@
+// AI search - transposition table, parallel alpha-beta and endgame solver
+#ifndef OTHELLO_SEARCH_H
+#define OTHELLO_SEARCH_H
+
+#include "position.h"
+#include "eval.h"
+#include "symmetry.h"
+#include "profile.h"
+#include <climits>      // For INT_MAX
+#include <cmath>        // For pow
+#include <cstddef>      // For size_t
+#include <cstdio>       // For snprintf
+#include <memory>       // For unique_ptr
+#include <chrono>       // For the AI thinking clock
+#include <atomic>       // For the lock-free table and stop flags
+#include <algorithm>    // For max
+#include <new>          // For placement new
+#include <vector>       // For the per-iteration log
+
+const int INF_SCORE = INT_MAX;  // Search window bound
+const int WIN_SCORE = 100000;   // Base score of a won final position
+const size_t TT_SIZE_MB = 16;   // Transposition table size per AI player
+const int MAX_PLY = 128;        // Deepest search line, passes included
+const int MAX_MOVES = 64;       // Move list size: any position set up by hand can have a move per empty square
+const int SOLVE_EMPTIES = 16;   // Solve the endgame exactly from this many empty squares
+const int FASTEST_FIRST_EMPTIES = 7;    // Endgame solver orders by opponent mobility above this
+const int MOBILITY_ORDER_DEPTH = 4;     // Midgame search orders by opponent mobility from this depth
+const int ASPIRATION_WINDOW = 32;       // Initial half-width of the root search window
+
+// Transposition table bound types
+enum Bound : uint8_t { BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+
+const uint8_t NO_MOVE = 64;     // Square index meaning "no move stored"
+
+// Decoded transposition table entry
+struct TTEntry {
+    uint64_t key = 0;           // Full Zobrist key of the position
+    int score = 0;              // Search score from the side to move's point of view
+    int depth = -1;             // Remaining depth the score was searched to
+    Bound bound = BOUND_NONE;   // Whether score is exact, a lower or an upper bound
+    int move = NO_MOVE;         // Best (or refuting) move found
+    uint8_t age = 0;            // Search generation that wrote the entry
+
+    // Pack everything but the key into one word: score | depth | move | age | bound
+    uint64_t Pack() const {
+        return (uint64_t)(uint32_t)score | (uint64_t)(uint8_t)depth << 32 | (uint64_t)(uint8_t)move << 40
+             | (uint64_t)age << 48 | (uint64_t)bound << 56;
+    }
+
+    static TTEntry Unpack(uint64_t key, uint64_t data) {
+        TTEntry e;
+        e.key = key;
+        e.score = (int32_t)(uint32_t)data;
+        e.depth = (int8_t)(data >> 32);
+        e.move = (uint8_t)(data >> 40);
+        e.age = (uint8_t)(data >> 48);
+        e.bound = (Bound)(data >> 56);
+        return e;
+    }
+};
+
+// One table slot (16 bytes, four per cache line). Written by several search
+// threads without locks: the key is stored XORed with the data, so a slot torn
+// by two concurrent writers no longer matches any key and is simply a miss.
+struct TTSlot {
+    std::atomic<uint64_t> check{0}; // key ^ data
+    std::atomic<uint64_t> data{0};
+
+    TTEntry Load() const {
+        uint64_t d = data.load(std::memory_order_relaxed);
+        return TTEntry::Unpack(check.load(std::memory_order_relaxed) ^ d, d);
+    }
+
+    void Save(const TTEntry& e) {
+        uint64_t d = e.Pack();
+        check.store(e.key ^ d, std::memory_order_relaxed);
+        data.store(d, std::memory_order_relaxed);
+    }
+};
+
+// Cache-line sized bucket: the first slots keep the deepest results,
+// the last one is always overwritten so recent positions are never lost
+struct alignas(64) TTBucket {
+    static const int SLOTS = 4;
+    static const int DEPTH_SLOTS = SLOTS - 1;
+    TTSlot slots[SLOTS];
+};
+
+// Fixed-size transposition table, shared lock-free by all search threads
+class TranspositionTable {
+    private:
+        std::unique_ptr<char[]> storage;    // Raw allocation, aligned by hand to 64 bytes
+        TTBucket* buckets = nullptr;
+        size_t mask = 0;                // Bucket count - 1 (count is a power of two)
+        std::atomic<uint8_t> age{0};    // Atomic so several players can share the table
+
+    public:
+        explicit TranspositionTable(size_t sizeMB) {
+            Resize(sizeMB);
+        }
+
+        ~TranspositionTable() {
+            for (size_t i = 0; buckets && i <= mask; i++) buckets[i].~TTBucket();
+        }
+
+        // Reallocate to the largest power-of-two bucket count that fits in sizeMB
+        void Resize(size_t sizeMB) {
+            for (size_t i = 0; buckets && i <= mask; i++) buckets[i].~TTBucket();
+
+            size_t count = 1;
+            size_t bytes = std::max<size_t>(sizeMB, 1) << 20;
+            while (count * 2 * sizeof(TTBucket) <= bytes) count *= 2;
+
+            storage.reset(new char[count * sizeof(TTBucket) + 63]);
+            std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(storage.get()) + 63) & ~std::uintptr_t(63);
+            buckets = reinterpret_cast<TTBucket*>(p);
+            mask = count - 1;
+            for (size_t i = 0; i <= mask; i++) new (&buckets[i]) TTBucket();
+            age = 0;
+        }
+
+        // Not safe while a search is running
+        void Clear() {
+            for (size_t i = 0; i <= mask; i++)
+                for (TTSlot& slot : buckets[i].slots) slot.Save(TTEntry());
+            age = 0;
+        }
+
+        // Called once per root search so older results are replaced first
+        void NewSearch() {
+            age.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        bool Probe(uint64_t key, TTEntry& out) const {
+            const TTBucket& bucket = buckets[key & mask];
+            for (const TTSlot& slot : bucket.slots) {
+                TTEntry e = slot.Load();
+                if (e.key == key && e.bound != BOUND_NONE) {
+                    out = e;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void Store(uint64_t key, int depth, Bound bound, int score, int move) {
+            TTBucket& bucket = buckets[key & mask];
+            TTEntry entries[TTBucket::SLOTS];
+            for (int i = 0; i < TTBucket::SLOTS; i++) entries[i] = bucket.slots[i].Load();
+            int slot = -1;
+
+            // Same position: update in place, keeping the old move if we have none
+            for (int i = 0; i < TTBucket::SLOTS; i++) {
+                if (entries[i].key == key && entries[i].bound != BOUND_NONE) {
+                    slot = i;
+                    if (move == NO_MOVE) move = entries[i].move;
+                    break;
+                }
+            }
+
+            // Depth-preferred slots: take the stalest, then shallowest one if we are at least as deep
+            uint8_t age = this->age.load(std::memory_order_relaxed);
+            if (slot < 0) {
+                int weakest = 0;
+                for (int i = 1; i < TTBucket::DEPTH_SLOTS; i++) {
+                    const TTEntry& e = entries[i];
+                    const TTEntry& w = entries[weakest];
+                    bool older = (e.age != age) && (w.age == age);
+                    bool sameAge = (e.age == age) == (w.age == age);
+                    if (older || (sameAge && e.depth < w.depth)) weakest = i;
+                }
+                bool replace = entries[weakest].age != age || depth >= entries[weakest].depth;
+                slot = replace ? weakest : TTBucket::SLOTS - 1;  // Otherwise always-replace slot
+            }
+
+            TTEntry e;
+            e.key = key;
+            e.score = score;
+            e.depth = depth;
+            e.bound = bound;
+            e.move = move;
+            e.age = age;
+            bucket.slots[slot].Save(e);
+        }
+};
+
+typedef std::chrono::steady_clock Clock;
+
+// Search effort counters, kept per thread and summed after the search. Unlike
+// SearchProfile they are counted in every build: bench reports them, and they cost
+// a few increments per node.
+struct SearchCounters {
+    uint64_t ttProbes = 0;          // Transposition table lookups
+    uint64_t ttHits = 0;            // Lookups that found the position
+    uint64_t ttCutoffs = 0;         // Hits whose score ended the node without searching it
+    uint64_t cutoffs = 0;           // Beta cutoffs after searching a move
+    uint64_t firstMoveCutoffs = 0;  // Beta cutoffs by the first move tried
+
+    void Add(const SearchCounters& other) {
+        ttProbes += other.ttProbes;
+        ttHits += other.ttHits;
+        ttCutoffs += other.ttCutoffs;
+        cutoffs += other.cutoffs;
+        firstMoveCutoffs += other.firstMoveCutoffs;
+    }
+};
+
+// One completed iteration of the main thread
+struct IterationStats {
+    int depth = 0;
+    uint64_t nodes = 0;             // Main thread nodes since the search began
+    double seconds = 0;             // Time since the search began
+};
+
+// State shared by all threads working on one search
+struct SearchShared {
+    TranspositionTable* tt = nullptr;
+    Clock::time_point start;                // When the search began
+    Clock::time_point deadline;             // Main thread stops at this time
+    int maxDepth = MAX_PLY;                 // Deepest iteration
+    bool canonicalKeys = false;             // Key the table by symmetry-reduced positions
+    std::atomic<bool> stop{false};          // Main thread is done, helpers should stop too
+    std::atomic<bool> pondering{false};     // Searching on the opponent's time: the clock is off until
+                                            // this is cleared (ponder hit), then runs deadline - start
+    const std::atomic<bool>* cancelled = nullptr;   // Set from outside to abort the whole search
+};
+
+// One search thread: iterative deepening alpha-beta over a private Position.
+// With several threads (Lazy SMP) they all search the same root and only share
+// the transposition table; the main thread owns the clock.
+class SearchThread {
+    private:
+        SearchShared& shared;
+        bool isMain;                        // Checks the clock and stops the helpers when done
+
+        Clock::time_point deadline;         // Current stop time of the main thread
+        Clock::time_point clockStart;       // When the main thread's clock started
+        int budgetShare = 1;                // Current phase may use 1/budgetShare of the budget
+        bool pondering = false;             // Clock not started yet (see SearchShared::pondering)
+        bool stopped = false;               // Deadline hit or cancelled, current iteration is void
+        int rootDepth = 0;                  // Depth of the current iteration
+
+        int pvTable[MAX_PLY][MAX_PLY];      // Triangular principal variation table
+        int pvLength[MAX_PLY];
+        int prevPv[MAX_PLY];                // PV of the last completed iteration
+        int prevPvLength = 0;
+        bool followPV = false;              // Still on the previous PV at this node
+
+        // Move ordering memory, kept across iterations and searches
+        static const int HISTORY_MAX = 1 << 20;     // History scores are halved past this
+        static const int KILLER_KEY = 1 << 30;      // Order key of the first killer move
+        int killers[MAX_PLY][2];            // Last two cutoff moves per ply
+        int history[2][64];                 // Cutoff score per side (black, white) and square
+
+        Evaluator eval;                     // Pattern codes of the position being searched
+
+    public:
+        // Results of the last Run()
+        uint64_t nodes = 0;                 // Nodes visited
+        int completedDepth = 0;             // Deepest fully searched iteration
+        int bestRootMove = NO_MOVE;         // First move of its PV
+        int bestRootScore = 0;
+        bool bestRootWLD = false;           // The score only tells win, loss or draw (the exact solve ran out of time)
+        std::vector<int> pv;                // Its principal variation (NO_MOVE for a pass)
+        SearchCounters counters;
+        std::vector<IterationStats> iterations;    // Main thread only
+        SearchProfile profile;              // Filled only when PROFILING
+
+        SearchThread(SearchShared& shared, bool isMain, const EvalWeights& weights = EvalWeights::Active())
+            : shared(shared), isMain(isMain), eval(weights) {
+            profile.thread = NewProfileThreadId();
+            ClearHistory();
+        }
+
+        // Forget the killer and history tables (e.g. before a new game)
+        void ClearHistory() {
+            for (auto& k : killers) k[0] = k[1] = NO_MOVE;
+            for (auto& side : history)
+                for (int& v : side) v = 0;
+        }
+
+        // Score of a decided game with the given disc differential; always outranks
+        // any heuristic score
+        static int WinScore(int diff) {
+            if (diff > 0) return WIN_SCORE + diff;
+            if (diff < 0) return -WIN_SCORE + diff;
+            return 0;
+        }
+
+        // Final position: decided by disc count
+        static int FinalScore(const Position& pos) {
+            return WinScore(PopCount(pos.bits.Discs(pos.currentPlayer)) - PopCount(pos.bits.Discs(Opponent(pos.currentPlayer))));
+        }
+
+        // Poll the stop conditions every 1024 nodes; unless cancelled, the main
+        // thread always finishes depth 1 so there is a move to play
+        bool OutOfTime() {
+            if ((++nodes & 1023) == 0) {
+                if (shared.stop.load(std::memory_order_relaxed) ||
+                    (shared.cancelled && shared.cancelled->load(std::memory_order_relaxed))) {
+                    stopped = true;
+                } else if (isMain && rootDepth > 1 && PastDeadline()) {
+                    stopped = true;
+                }
+            }
+            return stopped;
+        }
+
+        // Main thread's time is up. A ponder search has no deadline until the ponder
+        // hit, which starts the clock with the full budget.
+        bool PastDeadline() {
+            if (pondering) {
+                if (shared.pondering.load(std::memory_order_relaxed)) return false;
+                pondering = false;
+                clockStart = Clock::now();
+                deadline = clockStart + (shared.deadline - shared.start) / budgetShare;
+            }
+            return Clock::now() >= deadline;
+        }
+
+        void CountCutoff(int moveIndex) {
+            counters.cutoffs++;
+            if (moveIndex == 0) counters.firstMoveCutoffs++;
+            if (PROFILING) profile.CountCutoff(moveIndex);
+        }
+
+        // Record a timed stretch of this search that began at start with startNodes
+        void ProfileSpanEnd(const char* name, int depth, Clock::time_point start, uint64_t startNodes) {
+            if (PROFILING) profile.spans.push_back({name, depth, start, Clock::now(), nodes - startNodes, !stopped});
+        }
+
+        void LogIteration(int depth) {
+            if (!isMain) return;
+            IterationStats it;
+            it.depth = depth;
+            it.nodes = nodes;
+            it.seconds = std::chrono::duration<double>(Clock::now() - shared.start).count();
+            iterations.push_back(it);
+        }
+
+        // Remember a move that caused a beta cutoff: as a killer at this ply and in
+        // the history table, weighted by the depth of the refuted subtree
+        void UpdateHistory(Cell player, int sq, int depth, int ply) {
+            if (killers[ply][0] != sq) {
+                killers[ply][1] = killers[ply][0];
+                killers[ply][0] = sq;
+            }
+            int& h = history[player == White_Disc][sq];
+            h += depth * depth;
+            if (h > HISTORY_MAX) {
+                for (auto& side : history)
+                    for (int& v : side) v /= 2;
+            }
+        }
+
+        // Fill order with the legal moves in search order: previous PV move, TT move,
+        // killers, then by history, static square weight and (at larger depths) how
+        // few replies the move leaves the opponent. Returns the move count.
+        int OrderMoves(const Position& pos, uint64_t moves, int depth, int ply, int pvMove, int ttMove, int* order) {
+            int count = 0;
+            const int firstMoves[2] = { pvMove, ttMove };
+            for (int m : firstMoves) {
+                if (m != NO_MOVE && (moves & (1ULL << m))) {
+                    order[count++] = m;
+                    moves &= ~(1ULL << m);
+                }
+            }
+
+            int first = count;
+            int keys[MAX_MOVES];
+            const int* hist = history[pos.currentPlayer == White_Disc];
+            uint64_t P = pos.bits.Discs(pos.currentPlayer);
+            uint64_t O = pos.bits.Discs(Opponent(pos.currentPlayer));
+            for (; moves; moves &= moves - 1) {
+                int sq = LowestBit(moves);
+                int key;
+                if (sq == killers[ply][0]) key = KILLER_KEY;
+                else if (sq == killers[ply][1]) key = KILLER_KEY - 1;
+                else {
+                    key = hist[sq] + 64 * SQUARE_WEIGHT[sq / BOARD_SIZE][sq % BOARD_SIZE];
+                    if (depth >= MOBILITY_ORDER_DEPTH) {
+                        if (PROFILING) profile.moveGens++;
+                        uint64_t flips = GetFlips(P, O, sq);
+                        key -= 256 * PopCount(GetMoves(O & ~flips, P | flips | (1ULL << sq)));
+                    }
+                }
+                // Insertion sort, highest key first
+                int i = count++;
+                for (; i > first && keys[i - 1] < key; i--) {
+                    keys[i] = keys[i - 1];
+                    order[i] = order[i - 1];
+                }
+                keys[i] = key;
+                order[i] = sq;
+            }
+            return count;
+        }
+
+        // Negamax alpha-beta; score is from the side to move's point of view.
+        // Moves are made and undone in place, so no board is copied per node.
+        int Minimax(Position& pos, int depth, int ply, int alpha, int beta) {
+            TranspositionTable& tt = *shared.tt;
+            pvLength[ply] = ply;
+            if (OutOfTime()) return 0;
+
+            if (depth == 0 || ply >= MAX_PLY - 1) {
+                if (PROFILING) {
+                    profile.evals++;
+                    profile.moveGens += EVAL_MOVE_GENS;
+                }
+                return eval.Score(pos);
+            }
+
+            // Transposition table: reuse earlier results for this position (never at the root,
+            // which must produce a move and a PV)
+            int ttMove = NO_MOVE;
+            TTEntry entry;
+            int sym = 0;
+            uint64_t key = shared.canonicalKeys ? CanonicalKey(pos, sym) : pos.hash;
+            counters.ttProbes++;
+            if (tt.Probe(key, entry)) {
+                counters.ttHits++;
+                if (entry.move != NO_MOVE) ttMove = TransformSquare(entry.move, InverseSymmetry(sym));
+                if (ply > 0 && entry.depth >= depth) {
+                    if (entry.bound == BOUND_EXACT ||
+                        (entry.bound == BOUND_LOWER && entry.score >= beta) ||
+                        (entry.bound == BOUND_UPPER && entry.score <= alpha)) {
+                        counters.ttCutoffs++;
+                        return entry.score;
+                    }
+                }
+            }
+
+            if (PROFILING) profile.moveGens++;
+            uint64_t moves = pos.LegalMoves();
+            if (moves == 0) {
+                if (PROFILING) profile.moveGens++;
+                if (pos.bits.LegalMoves(Opponent(pos.currentPlayer)) == 0) return FinalScore(pos);
+                if (followPV) followPV = ply < prevPvLength && prevPv[ply] == NO_MOVE;
+                pos.Pass();
+                int score = -Minimax(pos, depth - 1, ply + 1, -beta, -alpha);
+                pos.Pass();
+                pvTable[ply][ply] = NO_MOVE;
+                for (int i = ply + 1; i < pvLength[ply + 1]; i++) pvTable[ply][i] = pvTable[ply + 1][i];
+                pvLength[ply] = pvLength[ply + 1];
+                return score;
+            }
+
+            int pvMove = NO_MOVE;
+            if (followPV) {
+                if (ply < prevPvLength && prevPv[ply] != NO_MOVE) pvMove = prevPv[ply];
+                else followPV = false;
+            }
+            int order[MAX_MOVES];
+            int count = OrderMoves(pos, moves, depth, ply, pvMove, ttMove, order);
+
+            int alphaOrig = alpha;
+            int bestScore = -INF_SCORE;
+            int bestMove = NO_MOVE;
+
+            for (int i = 0; i < count && alpha < beta; i++) {
+                int sq = order[i];
+                if (i > 0 || sq != pvMove) followPV = false;   // Left the previous PV
+                Cell player = pos.currentPlayer;
+                uint64_t flips = pos.MakeMove(sq);
+                eval.Play(player, sq, flips);
+
+                // Principal variation search: the first move gets the full window, the
+                // rest only have to be proven worse with a null window; re-search if not
+                int score;
+                if (i == 0) {
+                    score = -Minimax(pos, depth - 1, ply + 1, -beta, -alpha);
+                } else {
+                    score = -Minimax(pos, depth - 1, ply + 1, -alpha - 1, -alpha);
+                    if (score > alpha && score < beta && !stopped)
+                        score = -Minimax(pos, depth - 1, ply + 1, -beta, -alpha);
+                }
+                pos.UndoMove(sq, flips);
+                eval.Undo();
+                if (stopped) return 0;
+
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestMove = sq;
+                    if (score > alpha) {
+                        // New best line: this move followed by the child's PV
+                        pvTable[ply][ply] = sq;
+                        for (int j = ply + 1; j < pvLength[ply + 1]; j++) pvTable[ply][j] = pvTable[ply + 1][j];
+                        pvLength[ply] = pvLength[ply + 1];
+                    }
+                }
+                alpha = std::max(alpha, bestScore);
+                if (alpha >= beta) {
+                    CountCutoff(i);
+                    UpdateHistory(pos.currentPlayer, sq, depth, ply);
+                }
+            }
+
+            Bound bound = bestScore <= alphaOrig ? BOUND_UPPER : bestScore >= beta ? BOUND_LOWER : BOUND_EXACT;
+            tt.Store(key, depth, bound, bestScore, bestMove == NO_MOVE ? NO_MOVE : TransformSquare(bestMove, sym));
+            return bestScore;
+        }
+
+        // Root search in a narrow window around the previous iteration's score,
+        // widened on the failing side until the score falls inside it
+        int AspirationSearch(Position& pos, int guess, bool useWindow) {
+            int delta = ASPIRATION_WINDOW;
+            bool narrow = useWindow && std::abs(guess) < WIN_SCORE;
+            int alpha = narrow ? guess - delta : -INF_SCORE;
+            int beta = narrow ? guess + delta : INF_SCORE;
+            while (true) {
+                followPV = true;
+                int score = Minimax(pos, rootDepth, 0, alpha, beta);
+                if (stopped) return 0;
+
+                delta *= 4;
+                bool wide = delta >= WIN_SCORE;     // Give up on the window
+                if (score <= alpha) alpha = wide ? -INF_SCORE : score - delta;
+                else if (score >= beta) beta = wide ? INF_SCORE : score + delta;
+                else return score;
+            }
+        }
+
+        // Iterative deepening until stopped, at the depth limit or past the last empty
+        // square. Helpers with an odd depthOffset search one ply deeper than the main
+        // thread so the threads spread over the tree.
+        void Deepen(Position& pos, int depthOffset) {
+            int empties = PopCount(pos.bits.Empty());
+            int lastDepth = std::min(empties, shared.maxDepth);
+            eval.Init(pos);
+            for (rootDepth = 1 + depthOffset; rootDepth <= lastDepth; rootDepth++) {
+                Clock::time_point spanStart = PROFILING ? Clock::now() : Clock::time_point();
+                uint64_t spanNodes = nodes;
+                int score = AspirationSearch(pos, rootDepth > 2 ? bestRootScore : 0, rootDepth > 2);
+                ProfileSpanEnd("depth", rootDepth, spanStart, spanNodes);
+                if (stopped) break;     // Unfinished iteration: keep the previous result
+
+                // Keep this iteration's PV to order the next one
+                prevPvLength = pvLength[0];
+                for (int i = 0; i < prevPvLength; i++) prevPv[i] = pvTable[0][i];
+                if (prevPvLength > 0 && prevPv[0] != NO_MOVE) {
+                    bestRootMove = prevPv[0];
+                    bestRootScore = score;
+                    pv.assign(prevPv, prevPv + prevPvLength);
+                    completedDepth = rootDepth;
+                    LogIteration(rootDepth);
+                }
+                if (isMain && PastDeadline()) break;
+            }
+        }
+
+        // Disc differential of a finished game; empty squares go to the winner
+        static int FinalDiff(uint64_t P, uint64_t O) {
+            int p = PopCount(P), o = PopCount(O);
+            int e = 64 - p - o;
+            return p > o ? p - o + e : p < o ? p - o - e : 0;
+        }
+
+        // Quadrants holding an odd number of empties; moving there first keeps the last move
+        static uint64_t OddQuadrants(uint64_t empty) {
+            const uint64_t QUADRANTS[4] = {
+                0x000000000F0F0F0FULL, 0x00000000F0F0F0F0ULL, 0x0F0F0F0F00000000ULL, 0xF0F0F0F000000000ULL
+            };
+            uint64_t odd = 0;
+            for (uint64_t q : QUADRANTS)
+                if (PopCount(empty & q) & 1) odd |= q;
+            return odd;
+        }
+
+        // Last empty square: no move generation, just the two possible flips
+        int SolveLast1(uint64_t P, uint64_t O, int sq) {
+            nodes++;
+            uint64_t bit = 1ULL << sq;
+            uint64_t flips = GetFlips(P, O, sq);
+            if (flips) return FinalDiff(P | flips | bit, O & ~flips);
+            flips = GetFlips(O, P, sq);
+            if (flips) return FinalDiff(P & ~flips, O | flips | bit);
+            return FinalDiff(P, O);
+        }
+
+        // Last 2-4 empties: loop over the parity-ordered empty list instead of generating moves
+        int SolveSmall(uint64_t P, uint64_t O, int alpha, int beta, const int* squares, int n, bool passed) {
+            if (n == 1) return SolveLast1(P, O, squares[0]);
+            nodes++;
+
+            int bestScore = -INF_SCORE;
+            for (int i = 0; i < n; i++) {
+                int sq = squares[i];
+                uint64_t flips = GetFlips(P, O, sq);
+                if (!flips) continue;
+
+                int rest[4];
+                for (int j = 0, k = 0; j < n; j++)
+                    if (j != i) rest[k++] = squares[j];
+                int score = -SolveSmall(O & ~flips, P | flips | (1ULL << sq), -beta, -alpha, rest, n - 1, false);
+
+                if (score > bestScore) {
+                    bestScore = score;
+                    if (score > alpha) alpha = score;
+                    if (alpha >= beta) break;
+                }
+            }
+
+            if (bestScore == -INF_SCORE) {
+                if (passed) return FinalDiff(P, O);     // Neither side can move
+                return -SolveSmall(O, P, -beta, -alpha, squares, n, true);
+            }
+            return bestScore;
+        }
+
+        // Exact alpha-beta on the final disc differential. Moves are ordered fastest-first
+        // (fewest opponent replies) while many empties remain, then by quadrant parity.
+        int Solve(uint64_t P, uint64_t O, int alpha, int beta, int empties) {
+            if (OutOfTime()) return 0;
+
+            if (empties <= 4) {
+                uint64_t empty = ~(P | O);
+                uint64_t odd = OddQuadrants(empty);
+                int squares[4], n = 0;
+                for (uint64_t e = empty & odd; e; e &= e - 1) squares[n++] = LowestBit(e);
+                for (uint64_t e = empty & ~odd; e; e &= e - 1) squares[n++] = LowestBit(e);
+                return SolveSmall(P, O, alpha, beta, squares, n, false);
+            }
+
+            if (PROFILING) profile.moveGens++;
+            uint64_t moves = GetMoves(P, O);
+            if (moves == 0) {
+                if (PROFILING) profile.moveGens++;
+                if (GetMoves(O, P) == 0) return FinalDiff(P, O);
+                return -Solve(O, P, -beta, -alpha, empties);
+            }
+
+            int order[MAX_MOVES], keys[MAX_MOVES], count = 0;
+            uint64_t odd = OddQuadrants(~(P | O));
+            for (; moves; moves &= moves - 1) {
+                int sq = LowestBit(moves);
+                int key = (odd >> sq) & 1 ? 0 : 1;
+                if (empties > FASTEST_FIRST_EMPTIES) {
+                    if (PROFILING) profile.moveGens++;
+                    uint64_t flips = GetFlips(P, O, sq);
+                    key += 2 * PopCount(GetMoves(O & ~flips, P | flips | (1ULL << sq)));
+                }
+                int i = count++;
+                for (; i > 0 && keys[i - 1] > key; i--) {
+                    keys[i] = keys[i - 1];
+                    order[i] = order[i - 1];
+                }
+                keys[i] = key;
+                order[i] = sq;
+            }
+
+            int bestScore = -INF_SCORE;
+            for (int i = 0; i < count; i++) {
+                int sq = order[i];
+                uint64_t flips = GetFlips(P, O, sq);
+                int score = -Solve(O & ~flips, P | flips | (1ULL << sq), -beta, -alpha, empties - 1);
+                if (stopped) return 0;
+
+                if (score > bestScore) {
+                    bestScore = score;
+                    if (score > alpha) alpha = score;
+                    if (alpha >= beta) {
+                        CountCutoff(i);
+                        break;
+                    }
+                }
+            }
+            return bestScore;
+        }
+
+        // Solve the root within [alpha, beta], trying firstMove first; sets bestMove
+        int SolveRoot(const Position& pos, int alpha, int beta, int firstMove, int& bestMove) {
+            uint64_t P = pos.bits.Discs(pos.currentPlayer);
+            uint64_t O = pos.bits.Discs(Opponent(pos.currentPlayer));
+            int empties = PopCount(pos.bits.Empty());
+            if (PROFILING) profile.moveGens++;
+            uint64_t moves = GetMoves(P, O);
+
+            int order[MAX_MOVES], count = 0;
+            if (firstMove != NO_MOVE && (moves & (1ULL << firstMove))) {
+                order[count++] = firstMove;
+                moves &= ~(1ULL << firstMove);
+            }
+            for (; moves; moves &= moves - 1) order[count++] = LowestBit(moves);
+
+            int bestScore = -INF_SCORE;
+            for (int i = 0; i < count; i++) {
+                int sq = order[i];
+                uint64_t flips = GetFlips(P, O, sq);
+                int score = -Solve(O & ~flips, P | flips | (1ULL << sq), -beta, -alpha, empties - 1);
+                if (stopped) return 0;
+
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestMove = sq;
+                    if (score > alpha) alpha = score;
+                    if (alpha >= beta) break;
+                }
+            }
+            return bestScore;
+        }
+
+        // Endgame: a short midgame search for a fallback move, then a win/loss/draw
+        // solve, then the exact disc differential, each kept only if it completes
+        void SolveEndgame(Position& pos) {
+            budgetShare = 8;
+            deadline = clockStart + (shared.deadline - shared.start) / budgetShare;
+            Deepen(pos, 0);
+            stopped = false;
+            budgetShare = 1;
+            deadline = clockStart + (shared.deadline - shared.start);
+            rootDepth = PopCount(pos.bits.Empty());
+
+            int move = bestRootMove;
+            Clock::time_point spanStart = PROFILING ? Clock::now() : Clock::time_point();
+            uint64_t spanNodes = nodes;
+            int wld = SolveRoot(pos, -1, 1, move, move);
+            ProfileSpanEnd("win/loss solve", rootDepth, spanStart, spanNodes);
+            if (stopped) return;
+            if (move != bestRootMove) pv.assign(1, move);  // The solver tracks no line past the root
+            bestRootMove = move;
+            bestRootScore = WinScore(wld > 0 ? 1 : wld < 0 ? -1 : 0);  // Outside (-1, 1) wld is only a bound
+            bestRootWLD = true;
+            completedDepth = rootDepth;
+            LogIteration(rootDepth);
+
+            if (PROFILING) spanStart = Clock::now();
+            spanNodes = nodes;
+            int exact = SolveRoot(pos, -64, 64, move, move);
+            ProfileSpanEnd("exact solve", rootDepth, spanStart, spanNodes);
+            if (stopped) return;
+            if (move != bestRootMove) pv.assign(1, move);
+            bestRootMove = move;
+            bestRootScore = WinScore(exact);
+            bestRootWLD = false;
+            LogIteration(rootDepth);
+        }
+
+        // Search pos until stopped. With solveEmpties or fewer empty squares the
+        // main thread solves the endgame instead of searching heuristically.
+        void Run(Position pos, int depthOffset, int solveEmpties) {
+            stopped = false;
+            nodes = 0;
+            prevPvLength = 0;
+            completedDepth = 0;
+            bestRootMove = NO_MOVE;
+            bestRootScore = 0;
+            bestRootWLD = false;
+            pv.clear();
+            counters = SearchCounters();
+            iterations.clear();
+            if (PROFILING) profile.Reset();
+            clockStart = shared.start;
+            deadline = shared.deadline;
+            pondering = isMain && shared.pondering;
+
+            if (isMain && PopCount(pos.bits.Empty()) <= solveEmpties) SolveEndgame(pos);
+            else Deepen(pos, depthOffset);
+            if (PROFILING) profile.nodes = nodes;
+
+            if (isMain) shared.stop = true;     // Helpers are only useful while the main thread runs
+        }
+};
+
+// A search score for display: discs for the side to move, "=+4" for an exact
+// endgame result, or "win"/"loss"/"draw" when only that much was solved
+inline std::string ScoreText(int score, bool wldOnly = false) {
+    if (wldOnly) return score > 0 ? "win" : score < 0 ? "loss" : "draw";
+    char text[32];
+    if (score >= WIN_SCORE) std::snprintf(text, sizeof text, "=+%d", score - WIN_SCORE);
+    else if (score <= -WIN_SCORE) std::snprintf(text, sizeof text, "=%d", score + WIN_SCORE);
+    else std::snprintf(text, sizeof text, "%+.1f", (double)score / EVAL_DISC);
+    return text;
+}
+
+// Summary of the last AI search
+struct SearchStats {
+    int depth = 0;              // Deepest completed iteration
+    int score = 0;              // Score of the chosen move for the side to move
+    bool wldOnly = false;       // score only tells win, loss or draw: the exact endgame solve ran out of time
+    uint64_t nodes = 0;         // Nodes over all threads
+    double seconds = 0;         // Wall-clock time
+    int threads = 1;
+    int move = NO_MOVE;         // Chosen move
+    std::vector<int> pv;        // Expected line from the chosen move (NO_MOVE for a pass)
+    bool fromBook = false;      // Move came from the opening book, nothing was searched
+    SearchCounters counters;    // Summed over all threads
+    std::vector<IterationStats> iterations;    // Main thread's completed iterations
+    SearchProfile profile;      // Summed over all threads, when PROFILING
+    std::vector<SearchProfile> threadProfiles; // Each thread's, spans included, when PROFILING
+
+    double NodesPerSecond() const { return seconds > 0 ? nodes / seconds : 0; }
+
+    double TTHitRate() const { return counters.ttProbes ? (double)counters.ttHits / counters.ttProbes : 0; }
+
+    // Fraction of beta cutoffs produced by the first move searched (move ordering quality)
+    double FirstMoveCutoffRate() const {
+        return counters.cutoffs ? (double)counters.firstMoveCutoffs / counters.cutoffs : 0;
+    }
+
+    // Effective branching factor: geometric mean growth of the main thread's
+    // node count per iteration (0 with fewer than two iterations)
+    double BranchingFactor() const {
+        if (iterations.size() < 2) return 0;
+        const IterationStats& first = iterations.front();
+        const IterationStats& last = iterations.back();
+        int plies = last.depth - first.depth;
+        if (plies <= 0 || first.nodes == 0) return 0;
+        return std::pow((double)last.nodes / first.nodes, 1.0 / plies);
+    }
+};
+
+// Multi-line profile of a search: the hot-path counters, cutoffs by move index,
+// each thread's share and the time per iteration. Empty unless PROFILING.
+inline std::string ProfileReport(const SearchStats& stats) {
+    if (!PROFILING || stats.fromBook) return "";
+    const SearchProfile& p = stats.profile;
+    char line[256];
+    std::string out;
+    std::snprintf(line, sizeof line, "  %llu nodes, %llu evals, %llu move generations, TT %llu probes, %.1f%% hits, %llu cutoffs\n",
+        (unsigned long long)p.nodes, (unsigned long long)p.evals, (unsigned long long)p.moveGens,
+        (unsigned long long)stats.counters.ttProbes, 100 * stats.TTHitRate(), (unsigned long long)stats.counters.ttCutoffs);
+    out += line;
+
+    uint64_t cutoffs = 0;
+    for (uint64_t c : p.cutoffsAt) cutoffs += c;
+    out += "  cutoffs by move:";
+    for (int i = 0; i < PROFILE_CUTOFF_SLOTS; i++) {
+        std::snprintf(line, sizeof line, " %d%s %.1f%%", i + 1, i == PROFILE_CUTOFF_SLOTS - 1 ? "+" : "",
+                      cutoffs ? 100.0 * p.cutoffsAt[i] / cutoffs : 0.0);
+        out += line;
+    }
+    out += "\n";
+
+    for (const SearchProfile& t : stats.threadProfiles) {
+        std::snprintf(line, sizeof line, "  thread %d: %llu nodes, %llu evals, %llu move generations\n", t.thread,
+            (unsigned long long)t.nodes, (unsigned long long)t.evals, (unsigned long long)t.moveGens);
+        out += line;
+    }
+    if (!stats.threadProfiles.empty()) {
+        out += "  main thread:";
+        for (const ProfileSpan& s : stats.threadProfiles[0].spans) {
+            std::snprintf(line, sizeof line, " %s %d %.3fs%s;", s.name, s.depth,
+                          std::chrono::duration<double>(s.end - s.start).count(), s.completed ? "" : " (cut)");
+            out += line;
+        }
+        out += "\n";
+    }
+    return out;
+}
+
+#endif
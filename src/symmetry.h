@@ -0,0 +1,119 @@
+// Board symmetries - the 8 rotations and reflections of a position, and the
+// canonical key shared by all symmetric copies of it
+#ifndef OTHELLO_SYMMETRY_H
+#define OTHELLO_SYMMETRY_H
+
+#include "position.h"
+
+// Symmetry s (0-7) mirrors the columns if s & 1, then the rows if s & 2, then
+// swaps rows and columns if s & 4 - the same numbering as the evaluator patterns
+const int SYMMETRIES = 8;
+
+// Column c -> 7 - c: reverse the bits of every row
+inline uint64_t MirrorHorizontal(uint64_t b) {
+    b = ((b >> 1) & 0x5555555555555555ULL) | ((b & 0x5555555555555555ULL) << 1);
+    b = ((b >> 2) & 0x3333333333333333ULL) | ((b & 0x3333333333333333ULL) << 2);
+    b = ((b >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((b & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return b;
+}
+
+// Row r -> 7 - r: reverse the byte order
+inline uint64_t FlipVertical(uint64_t b) {
+    return __builtin_bswap64(b);
+}
+
+// (r, c) -> (c, r): swap bits across the a1-h8 diagonal with three delta swaps
+inline uint64_t FlipDiagonal(uint64_t b) {
+    uint64_t t;
+    t = 0x0F0F0F0F00000000ULL & (b ^ (b << 28)); b ^= t ^ (t >> 28);
+    t = 0x3333000033330000ULL & (b ^ (b << 14)); b ^= t ^ (t >> 14);
+    t = 0x5500550055005500ULL & (b ^ (b << 7));  b ^= t ^ (t >> 7);
+    return b;
+}
+
+inline uint64_t TransformBits(uint64_t b, int s) {
+    if (s & 1) b = MirrorHorizontal(b);
+    if (s & 2) b = FlipVertical(b);
+    if (s & 4) b = FlipDiagonal(b);
+    return b;
+}
+
+inline int TransformSquare(int sq, int s) {
+    int r = sq / BOARD_SIZE, c = sq % BOARD_SIZE;
+    if (s & 1) c = 7 - c;
+    if (s & 2) r = 7 - r;
+    if (s & 4) { int t = r; r = c; c = t; }
+    return r * BOARD_SIZE + c;
+}
+
+// Symmetry undoing s: the reflections are their own inverses, and after a swap
+// the column and row mirrors trade places
+inline int InverseSymmetry(int s) {
+    return (s & 4) ? 4 | (s & 1) << 1 | (s & 2) >> 1 : s;
+}
+
+inline Position TransformPosition(const Position& pos, int s) {
+    Position t;
+    t.bits.black = TransformBits(pos.bits.black, s);
+    t.bits.white = TransformBits(pos.bits.white, s);
+    t.currentPlayer = pos.currentPlayer;
+    t.hash = t.ComputeHash();
+    return t;
+}
+
+// Symmetry taking bits to its canonical orientation: the one with the smallest
+// (black, white) masks, returned in black and white. Symmetric copies of a
+// position share that orientation. The 8 black masks are built from three
+// cheap reflections and four diagonal flips rather than 8 full transforms.
+inline int CanonicalSymmetry(const BitBoard& bits, uint64_t& black, uint64_t& white) {
+    uint64_t b[SYMMETRIES];
+    b[0] = bits.black;
+    b[1] = MirrorHorizontal(b[0]);
+    b[2] = FlipVertical(b[0]);
+    b[3] = FlipVertical(b[1]);
+    for (int s = 0; s < 4; s++) b[s | 4] = FlipDiagonal(b[s]);
+
+    int best = 0;
+    black = b[0];
+    white = bits.white;
+    for (int s = 1; s < SYMMETRIES; s++) {
+        if (b[s] > black) continue;
+        uint64_t w = TransformBits(bits.white, s);  // Only needed to beat or break a tie
+        if (b[s] < black || w < white) {
+            best = s;
+            black = b[s];
+            white = w;
+        }
+    }
+    return best;
+}
+
+inline int CanonicalSymmetry(const BitBoard& bits) {
+    uint64_t black, white;
+    return CanonicalSymmetry(bits, black, white);
+}
+
+// Key of a board from its masks (two splitmix64 steps). Canonical keys are a key
+// space of their own: never compare them with Position::hash.
+inline uint64_t BoardKey(uint64_t black, uint64_t white, Cell side) {
+    uint64_t state = white + (side == White_Disc ? ZOBRIST.side : 0);
+    uint64_t h = black ^ SplitMix64(state);
+    return SplitMix64(h);
+}
+
+// Key shared by all 8 symmetric copies of pos; s receives the symmetry that
+// takes pos to the canonical orientation. Moves stored under the key belong to
+// that orientation: TransformSquare(move, s) on the way in and
+// TransformSquare(move, InverseSymmetry(s)) on the way out.
+inline uint64_t CanonicalKey(const Position& pos, int& s) {
+    uint64_t black, white;
+    s = CanonicalSymmetry(pos.bits, black, white);
+    return BoardKey(black, white, pos.currentPlayer);
+}
+
+inline uint64_t CanonicalKey(const Position& pos) {
+    int s;
+    return CanonicalKey(pos, s);
+}
+
+#endif
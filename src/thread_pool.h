@@ -0,0 +1,82 @@
+// Fixed-size worker pool for batch jobs (self-play matches, analysis)
+#ifndef OTHELLO_THREAD_POOL_H
+#define OTHELLO_THREAD_POOL_H
+
+#include <algorithm>            // For max
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+    private:
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> tasks;   // Waiting to run
+        std::mutex mutex;
+        std::condition_variable wakeWorker;         // A task was queued or the pool is closing
+        std::condition_variable allDone;            // Queue drained and no task running
+        int running = 0;                            // Tasks being executed right now
+        bool closing = false;
+
+        void WorkerLoop() {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wakeWorker.wait(lock, [this]() { return closing || !tasks.empty(); });
+                    if (tasks.empty()) return;  // Closing and nothing left to do
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                    running++;
+                }
+                task();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    running--;
+                    if (running == 0 && tasks.empty()) allDone.notify_all();
+                }
+            }
+        }
+
+    public:
+        // threads = 0 starts one worker per hardware core
+        explicit ThreadPool(int threads = 0) {
+            if (threads <= 0) threads = std::max(1, (int)std::thread::hardware_concurrency());
+            for (int i = 0; i < threads; i++) workers.emplace_back([this]() { WorkerLoop(); });
+        }
+
+        // Finishes every queued task before returning
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                closing = true;
+            }
+            wakeWorker.notify_all();
+            for (std::thread& t : workers) t.join();
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        int Size() const {
+            return (int)workers.size();
+        }
+
+        void Submit(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tasks.push_back(std::move(task));
+            }
+            wakeWorker.notify_one();
+        }
+
+        // Block until every submitted task has finished
+        void Wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            allDone.wait(lock, [this]() { return running == 0 && tasks.empty(); });
+        }
+};
+
+#endif
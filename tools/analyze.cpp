@@ -0,0 +1,317 @@
+// Batch position analysis
+//
+// Searches every position of an input file on all cores and writes one line per
+// position, in input order, as soon as it and every position before it are done:
+//
+//   index  id  best-move  score  depth  nodes  pv
+//
+// Scores are for the side to move, in discs; an exact endgame result is written
+// as "=+4", and one whose exact solve ran out of time after the win/loss/draw
+// solve as "win", "loss" or "draw". Passes in the PV are written as "pass".
+//
+//   analyze [--time SECONDS] [--depth N] [--solve EMPTIES] [--tt MB] [--threads N]
+//           [--jobs N] [--window N] [--weights FILE] [--book FILE] [--canonical] [FILE]
+//
+// FILE (stdin when missing or "-") holds one board per line in perft's 64-cell
+// notation (blank lines and lines starting with '#' are skipped), or is a
+// training file (selfplay --record) or a game record file (selfplay --save-games,
+// the game's games.bin), which are memory-mapped and have every position with a
+// move to play analysed.
+//
+// Each worker owns an engine (one search thread by default, --threads for more)
+// and takes the next unread position whenever it finishes one, so slow positions
+// never hold up the others. At most --window positions are in flight past the
+// oldest unfinished one, which bounds the memory used to put the output in order.
+#include "player.h"
+#include "book.h"
+#include "game_record.h"
+#include "thread_pool.h"
+#include "training_data.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <vector>
+using namespace std;
+
+// One position to analyse; a text line that is not a board has an error instead
+struct Job {
+    size_t index = 0;
+    string id;
+    Position pos;
+    string error;
+};
+
+class PositionSource {
+    public:
+        virtual ~PositionSource() {}
+        // Next position in input order, false at the end of the input
+        virtual bool Next(Job& job) = 0;
+};
+
+// Board strings, one per line
+class TextSource : public PositionSource {
+    private:
+        istream& in;
+        size_t line = 0;
+
+    public:
+        explicit TextSource(istream& in) : in(in) {}
+
+        bool Next(Job& job) override {
+            string text;
+            while (getline(in, text)) {
+                line++;
+                size_t first = text.find_first_not_of(" \t\r");
+                if (first == string::npos || text[first] == '#') continue;
+                job.id = "line" + to_string(line);
+                if (!ParseBoard(text, job.pos)) job.error = "bad board";
+                return true;
+            }
+            return false;
+        }
+};
+
+// Positions of a mapped training file
+class TrainingFileSource : public PositionSource {
+    private:
+        MappedFile file;
+        const TrainingRecord* records;
+        size_t count, next = 0;
+
+    public:
+        explicit TrainingFileSource(const string& path) {
+            file.Open(path, true);
+            records = TrainingRecords(file.Data(), file.Size(), count);
+        }
+
+        bool Next(Job& job) override {
+            if (next >= count) return false;
+            const TrainingRecord& r = records[next];
+            job.id = "record" + to_string(next++);
+            job.pos.bits.black = r.black;
+            job.pos.bits.white = r.white;
+            job.pos.currentPlayer = (Cell)r.side;
+            job.pos.hash = job.pos.ComputeHash();
+            return true;
+        }
+};
+
+// Every position with a move to play in the games of a game record file
+class GameFileSource : public PositionSource {
+    private:
+        GameReader reader;
+        GameView game;
+        size_t gameIndex = 0;
+        int ply = 0;            // Next move byte of the current game
+        Position pos;           // Position before that move
+        bool inGame = false;
+
+    public:
+        explicit GameFileSource(const string& path) : reader(path) {}
+
+        bool Next(Job& job) override {
+            for (;;) {
+                if (!inGame) {
+                    if (!reader.Next(game)) return false;
+                    gameIndex++;
+                    ply = 0;
+                    pos = Position();
+                    inGame = true;
+                }
+                if (ply >= game.MoveCount()) {
+                    inGame = false;
+                    continue;
+                }
+                uint8_t move = game.moves[ply];
+                if (move == MOVE_PASS) {
+                    pos.Pass();
+                    ply++;
+                    continue;
+                }
+                if (move >= 64 || !(pos.LegalMoves() & (1ULL << move))) {
+                    cerr << "analyze: illegal move in game " << gameIndex << ", skipping the rest of it\n";
+                    inGame = false;
+                    continue;
+                }
+                job.id = "game" + to_string(gameIndex) + "/ply" + to_string(ply);
+                job.pos = pos;
+                pos.MakeMove(move);
+                ply++;
+                return true;
+            }
+        }
+
+        size_t BadBlocks() const { return reader.BadBlocks(); }
+};
+
+// Training or game file by its magic, anything else as text
+static unique_ptr<PositionSource> OpenSource(const string& path, unique_ptr<ifstream>& text) {
+    char magic[8] = {};
+    {
+        ifstream peek(path, ios::binary);
+        if (!peek) throw runtime_error("Cannot open " + path);
+        peek.read(magic, sizeof magic);
+    }
+    if (memcmp(magic, TRAINING_MAGIC, sizeof magic) == 0) return unique_ptr<PositionSource>(new TrainingFileSource(path));
+    if (memcmp(magic, GAME_FILE_MAGIC, sizeof magic) == 0) return unique_ptr<PositionSource>(new GameFileSource(path));
+    text.reset(new ifstream(path));
+    return unique_ptr<PositionSource>(new TextSource(*text));
+}
+
+static string Analyze(AIPlayer& engine, const Job& job) {
+    string line = to_string(job.index) + "\t" + job.id + "\t";
+    if (!job.error.empty()) return line + "error: " + job.error + "\n";
+    if (job.pos.LegalMoves() == 0)
+        return line + (job.pos.IsGameOver() ? "game-over" : "pass") + "\t-\t0\t0\t-\n";
+
+    int move = engine.Search(job.pos);
+    const SearchStats& stats = engine.LastStats();
+    line += SquareName(move) + "\t" + ScoreText(stats.score, stats.wldOnly) + "\t" + to_string(stats.depth) + "\t"
+          + to_string(stats.nodes) + "\t";
+    for (size_t i = 0; i < stats.pv.size(); i++) line += (i ? " " : "") + SquareName(stats.pv[i]);
+    return line + "\n";
+}
+
+// Hands out positions in input order and writes results back in input order
+class Scheduler {
+    private:
+        PositionSource& source;
+        size_t window;
+        mutex m;
+        condition_variable windowOpen;      // The oldest unfinished position was written
+        bool exhausted = false;
+        size_t nextIndex = 0;               // Next position to hand out
+        size_t nextOut = 0;                 // Next position to write
+        vector<string> results;             // Finished lines, by index % window
+        vector<bool> ready;
+
+    public:
+        uint64_t nodes = 0;
+
+        Scheduler(PositionSource& source, size_t window)
+            : source(source), window(window), results(window), ready(window, false) {}
+
+        // Next position to analyse; false when the input is used up
+        bool Take(Job& job) {
+            unique_lock<mutex> lock(m);
+            windowOpen.wait(lock, [this]() { return exhausted || nextIndex < nextOut + window; });
+            if (exhausted) return false;
+            job = Job();
+            if (!source.Next(job)) {
+                exhausted = true;
+                windowOpen.notify_all();
+                return false;
+            }
+            job.index = nextIndex++;
+            return true;
+        }
+
+        // Store a finished line and write every line that is now in order
+        void Finish(const Job& job, string line, uint64_t jobNodes) {
+            lock_guard<mutex> lock(m);
+            nodes += jobNodes;
+            results[job.index % window] = move(line);
+            ready[job.index % window] = true;
+            bool advanced = false;
+            while (ready[nextOut % window]) {
+                fputs(results[nextOut % window].c_str(), stdout);
+                ready[nextOut % window] = false;
+                nextOut++;
+                advanced = true;
+                if (nextOut % 1000 == 0) cerr << nextOut << " positions\r" << flush;
+            }
+            if (advanced) windowOpen.notify_all();
+        }
+
+        size_t Written() {
+            lock_guard<mutex> lock(m);
+            return nextOut;
+        }
+};
+
+static void Usage() {
+    cerr << "usage: analyze [--time SECONDS] [--depth N] [--solve EMPTIES] [--tt MB] [--threads N]\n"
+            "               [--jobs N] [--window N] [--weights FILE] [--book FILE] [--canonical] [FILE]\n"
+            "FILE: board strings (one per line), a training file or a game record file; '-' or none for stdin\n";
+}
+
+int main(int argc, char** argv) {
+    AISettings settings;
+    settings.thinkTime = 1.0;
+    settings.threads = 1;       // One search per worker thread
+    settings.ttSizeMB = 16;
+    int jobs = 0;
+    size_t window = 0;          // 0 = 64 per worker
+    string path = "-";
+    unique_ptr<EvalWeights> weights;
+    unique_ptr<OpeningBook> book;
+    bool timeGiven = false;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--time" && hasValue) {
+                settings.thinkTime = atof(argv[++i]);
+                timeGiven = true;
+            }
+            else if (arg == "--depth" && hasValue) settings.maxDepth = atoi(argv[++i]);
+            else if (arg == "--solve" && hasValue) settings.solveEmpties = atoi(argv[++i]);
+            else if (arg == "--tt" && hasValue) settings.ttSizeMB = (size_t)atoi(argv[++i]);
+            else if (arg == "--threads" && hasValue) settings.threads = atoi(argv[++i]);
+            else if (arg == "--jobs" && hasValue) jobs = atoi(argv[++i]);
+            else if (arg == "--window" && hasValue) window = (size_t)atoi(argv[++i]);
+            else if (arg == "--weights" && hasValue) weights.reset(new EvalWeights(EvalWeights::Load(argv[++i])));
+            else if (arg == "--book" && hasValue) book.reset(new OpeningBook(argv[++i]));
+            else if (arg == "--canonical") settings.canonicalTT = true;
+            else if (arg.size() > 1 && arg[0] == '-') { Usage(); return 1; }
+            else path = arg;
+        }
+        // A depth limit alone means "search to that depth", however long it takes
+        if (settings.maxDepth < MAX_PLY && !timeGiven) settings.thinkTime = 1e9;
+        settings.weights = weights.get();
+        settings.book = book.get();
+
+        unique_ptr<ifstream> textFile;
+        unique_ptr<PositionSource> source = path == "-" ? unique_ptr<PositionSource>(new TextSource(cin))
+                                                        : OpenSource(path, textFile);
+
+        ThreadPool pool(jobs);
+        Scheduler scheduler(*source, window ? window : 64 * (size_t)pool.Size());
+        auto start = chrono::steady_clock::now();
+        printf("# index\tid\tmove\tscore\tdepth\tnodes\tpv\n");
+
+        for (int t = 0; t < pool.Size(); t++) {
+            pool.Submit([&]() {
+                AIPlayer engine(settings);
+                Job job;
+                while (scheduler.Take(job)) {
+                    string line = Analyze(engine, job);
+                    uint64_t nodes = job.error.empty() && job.pos.LegalMoves() ? engine.LastStats().nodes : 0;
+                    scheduler.Finish(job, move(line), nodes);
+                }
+            });
+        }
+        pool.Wait();
+        fflush(stdout);
+
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        size_t positions = scheduler.Written();
+        cerr << positions << " positions, " << scheduler.nodes << " nodes in " << seconds << " s ("
+             << (seconds > 0 ? positions / seconds : 0) << " positions/s, "
+             << (uint64_t)(seconds > 0 ? scheduler.nodes / seconds : 0) << " nodes/s) on " << pool.Size() << " threads\n";
+        if (GameFileSource* games = dynamic_cast<GameFileSource*>(source.get()))
+            if (games->BadBlocks()) cerr << "Skipped " << games->BadBlocks() << " damaged blocks of " << path << "\n";
+    } catch (const exception& e) {
+        cerr << "analyze: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
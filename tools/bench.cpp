@@ -0,0 +1,277 @@
+// Search benchmark over a fixed suite of midgame and endgame positions
+//
+// Runs AIPlayer::Search on every position at a fixed depth and/or a fixed time
+// per move and reports nodes, nodes/s, time to each depth, effective branching
+// factor, transposition table hit rate and cutoff statistics, per position and
+// in total. Results go to a JSON file so builds can be diffed.
+//
+//   bench [--mode depth|time|both] [--depth N] [--time SECONDS] [--threads LIST]
+//         [--tt MB] [--solve EMPTIES] [--canonical] [--positions FILE] [--weights FILE] [--json FILE]
+//
+// --threads takes a comma-separated list (e.g. "1,2,4"); every mode is run once
+// per thread count and the speedup over the first count is reported.
+// --positions reads "name BOARD" lines, BOARD in perft's 64-cell notation.
+// --canonical keys the transposition table by symmetry-reduced positions.
+#include "player.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct BenchPosition {
+    string name;
+    Position pos;
+};
+
+// Positions from engine games, Black to move
+static const char* const SUITE[][2] = {
+    {"mid44", "-----O------O---OOOOXX---OOOOX---OOOOXX-O----------------------- X"},
+    {"mid40", "--X-OO-----XO---OOOOOO---XOXOX--X-OXO-X---O----X--O------------- X"},
+    {"mid36", "--XX------XX-O----XOOO---XXOOO---OXXO---OOXXXX----XX------X-O--- X"},
+    {"mid32", "---X-O------XO--OOOOXX-O-OOOXXO--OOXOOXOO-XXOO-X---O------O----- X"},
+    {"mid28", "--X-OO----XXO---OXXXOOO-XXXOXO-OXOOXOXO-OOOO-O-X--X-O-----X----- X"},
+    {"mid24", "--XX-X----XXXX--OOXXXX---OOOXXX--OOOOXX-OOOOOOOX--XXOO----X-OO-- X"},
+    {"end20", "-XXX-O----XXXO--OOXXOOOO-OXXXOO-OOXOOOXOOOXOXXXX--OO-O----OOX--- X"},
+    {"end18", "--XXOX---XXOOX--OOXXOX-O-OOXOXO--OOOXOX-OOOOOXXX--OXXO-X-OOOOO-- X"},
+    {"end16", "--XXXXX--OXXXX--OOOXXXXXXOXOXXXOXOOXXXOOOOOOXXXX--O-O-----XXXO-- X"},
+    {"end14", "-XXXXXX---XOOX--OXOXXOOOXOXXXOO-OXXOOOXOOOXOOXOO--OOOO-O-XXXX--- X"},
+};
+
+static vector<BenchPosition> BuiltinPositions() {
+    vector<BenchPosition> positions;
+    for (const auto& entry : SUITE) {
+        BenchPosition p;
+        p.name = entry[0];
+        if (!ParseBoard(entry[1], p.pos)) throw runtime_error(string("Bad suite board ") + entry[0]);
+        positions.push_back(p);
+    }
+    return positions;
+}
+
+// "name BOARD" per line; '#' starts a comment
+static vector<BenchPosition> LoadPositions(const string& path) {
+    ifstream in(path);
+    if (!in) throw runtime_error("Cannot open " + path);
+    vector<BenchPosition> positions;
+    string line;
+    while (getline(in, line)) {
+        size_t hash = line.find('#');
+        if (hash != string::npos) line.erase(hash);
+        stringstream ss(line);
+        BenchPosition p;
+        if (!(ss >> p.name)) continue;
+        string board;
+        getline(ss, board);
+        if (!ParseBoard(board, p.pos)) throw runtime_error("Bad board for " + p.name + " in " + path);
+        positions.push_back(p);
+    }
+    return positions;
+}
+
+struct Result {
+    string name;
+    int empties = 0;
+    SearchStats stats;
+};
+
+struct Run {
+    string mode;                    // "depth" or "time"
+    int threads = 1;
+    vector<Result> results;
+    SearchStats total;              // Summed nodes, time and counters
+    double branchingFactor = 0;     // Geometric mean over positions with one
+};
+
+static Run RunSuite(const vector<BenchPosition>& positions, AISettings settings, const string& mode, ostream& report) {
+    Run run;
+    run.mode = mode;
+    run.threads = settings.threads;
+    AIPlayer ai(settings);
+
+    double logEbf = 0;
+    int ebfCount = 0;
+    for (const BenchPosition& p : positions) {
+        ai.NewGame();                   // Every position starts from an empty table
+        Result r;
+        r.name = p.name;
+        r.empties = PopCount(p.pos.bits.Empty());
+        if (ai.Search(p.pos) < 0) continue;
+        r.stats = ai.LastStats();
+
+        const SearchStats& s = r.stats;
+        run.total.nodes += s.nodes;
+        run.total.seconds += s.seconds;
+        run.total.counters.Add(s.counters);
+        if (s.BranchingFactor() > 0) {
+            logEbf += log(s.BranchingFactor());
+            ebfCount++;
+        }
+
+        char line[200];
+        snprintf(line, sizeof line, "%-8s %2d empties  depth %2d  move %-4s %12llu nodes  %7.3f s  %7.2f Mn/s  ebf %5.2f  tt %4.1f%%  1st %4.1f%%",
+                 r.name.c_str(), r.empties, s.depth, SquareName(s.move).c_str(), (unsigned long long)s.nodes, s.seconds,
+                 s.NodesPerSecond() / 1e6, s.BranchingFactor(), 100 * s.TTHitRate(), 100 * s.FirstMoveCutoffRate());
+        report << line << "\n" << ProfileReport(s);
+        run.results.push_back(r);
+    }
+    run.total.threads = settings.threads;
+    run.branchingFactor = ebfCount ? exp(logEbf / ebfCount) : 0;
+
+    const SearchStats& t = run.total;
+    char line[200];
+    snprintf(line, sizeof line, "total    %12llu nodes  %7.3f s  %7.2f Mn/s  ebf %5.2f  tt %4.1f%%  1st %4.1f%%",
+             (unsigned long long)t.nodes, t.seconds, t.NodesPerSecond() / 1e6, run.branchingFactor,
+             100 * t.TTHitRate(), 100 * t.FirstMoveCutoffRate());
+    report << line << "\n";
+    return run;
+}
+
+// Counters and rates shared by the per-position and total JSON objects
+static void WriteStatsJson(ostream& out, const SearchStats& s) {
+    out << "\"nodes\": " << s.nodes
+        << ", \"seconds\": " << s.seconds
+        << ", \"nps\": " << (uint64_t)s.NodesPerSecond()
+        << ", \"tt_probes\": " << s.counters.ttProbes
+        << ", \"tt_hits\": " << s.counters.ttHits
+        << ", \"tt_hit_rate\": " << s.TTHitRate()
+        << ", \"tt_cutoffs\": " << s.counters.ttCutoffs
+        << ", \"cutoffs\": " << s.counters.cutoffs
+        << ", \"first_move_cutoffs\": " << s.counters.firstMoveCutoffs
+        << ", \"first_move_cutoff_rate\": " << s.FirstMoveCutoffRate();
+}
+
+static void WriteJson(ostream& out, const vector<Run>& runs, const AISettings& settings) {
+    out.precision(6);
+    out << "{\n  \"settings\": {\"depth\": " << settings.maxDepth << ", \"time\": " << settings.thinkTime
+        << ", \"tt_mb\": " << settings.ttSizeMB << ", \"solve_empties\": " << settings.solveEmpties
+        << ", \"canonical_tt\": " << (settings.canonicalTT ? "true" : "false") << "},\n";
+    out << "  \"runs\": [\n";
+    for (size_t r = 0; r < runs.size(); r++) {
+        const Run& run = runs[r];
+        out << "    {\"mode\": \"" << run.mode << "\", \"threads\": " << run.threads << ",\n";
+        out << "     \"positions\": [\n";
+        for (size_t i = 0; i < run.results.size(); i++) {
+            const Result& res = run.results[i];
+            const SearchStats& s = res.stats;
+            out << "       {\"name\": \"" << res.name << "\", \"empties\": " << res.empties
+                << ", \"depth\": " << s.depth << ", \"move\": \"" << SquareName(s.move) << "\", \"score\": " << s.score
+                << ", ";
+            WriteStatsJson(out, s);
+            out << ", \"ebf\": " << s.BranchingFactor() << ",\n        \"iterations\": [";
+            for (size_t k = 0; k < s.iterations.size(); k++) {
+                const IterationStats& it = s.iterations[k];
+                out << (k ? ", " : "") << "{\"depth\": " << it.depth << ", \"nodes\": " << it.nodes
+                    << ", \"seconds\": " << it.seconds << "}";
+            }
+            out << "]}" << (i + 1 < run.results.size() ? "," : "") << "\n";
+        }
+        out << "     ],\n     \"total\": {";
+        WriteStatsJson(out, run.total);
+        out << ", \"ebf\": " << run.branchingFactor;
+
+        // Speedup over the first thread count of the same mode: time to the same
+        // depths for fixed-depth runs, node rate for fixed-time runs
+        for (const Run& base : runs) {
+            if (base.mode != run.mode) continue;
+            double speedup = run.mode == "depth" ? base.total.seconds / run.total.seconds
+                                                 : run.total.NodesPerSecond() / base.total.NodesPerSecond();
+            out << ", \"speedup\": " << speedup;
+            break;
+        }
+        out << "}}" << (r + 1 < runs.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+static vector<int> ParseList(const string& text) {
+    vector<int> values;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        int v = atoi(item.c_str());
+        if (v <= 0) throw runtime_error("Bad thread count '" + item + "'");
+        values.push_back(v);
+    }
+    return values;
+}
+
+static void Usage() {
+    cerr << "usage: bench [--mode depth|time|both] [--depth N] [--time SECONDS] [--threads LIST]\n"
+            "             [--tt MB] [--solve EMPTIES] [--canonical] [--positions FILE] [--weights FILE] [--json FILE]\n"
+            "             [--trace FILE]\n";
+}
+
+int main(int argc, char** argv) {
+    string mode = "both";
+    string positionsFile;
+    string jsonFile = "bench.json";
+    vector<int> threadCounts = {1};
+    AISettings settings;
+    settings.maxDepth = 10;
+    settings.thinkTime = 0.5;
+    settings.solveEmpties = 14;
+    unique_ptr<TraceFile> trace;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--mode" && hasValue) mode = argv[++i];
+            else if (arg == "--depth" && hasValue) settings.maxDepth = atoi(argv[++i]);
+            else if (arg == "--time" && hasValue) settings.thinkTime = atof(argv[++i]);
+            else if (arg == "--threads" && hasValue) threadCounts = ParseList(argv[++i]);
+            else if (arg == "--tt" && hasValue) settings.ttSizeMB = (size_t)atoi(argv[++i]);
+            else if (arg == "--solve" && hasValue) settings.solveEmpties = atoi(argv[++i]);
+            else if (arg == "--canonical") settings.canonicalTT = true;
+            else if (arg == "--positions" && hasValue) positionsFile = argv[++i];
+            else if (arg == "--weights" && hasValue) EvalWeights::Active() = EvalWeights::Load(argv[++i]);
+            else if (arg == "--json" && hasValue) jsonFile = argv[++i];
+            else if (arg == "--trace" && hasValue) trace.reset(new TraceFile(argv[++i]));
+            else { Usage(); return 1; }
+        }
+        if (mode != "depth" && mode != "time" && mode != "both") { Usage(); return 1; }
+        if (trace && !PROFILING) cerr << "bench: built without OTHELLO_PROFILE, the trace will stay empty\n";
+        settings.trace = trace.get();
+
+        vector<BenchPosition> positions = positionsFile.empty() ? BuiltinPositions() : LoadPositions(positionsFile);
+        if (positions.empty()) throw runtime_error("No positions");
+
+        // The table goes to stderr when the JSON goes to stdout
+        ostream& report = jsonFile == "-" ? cerr : cout;
+        vector<Run> runs;
+        for (const char* m : {"depth", "time"}) {
+            if (mode != "both" && mode != m) continue;
+            for (int threads : threadCounts) {
+                AISettings s = settings;
+                s.threads = threads;
+                if (string(m) == "depth") s.thinkTime = 1e9;     // Depth (or solve) is the only limit
+                else s.maxDepth = MAX_PLY;
+                report << "\n== fixed " << m << " (";
+                if (string(m) == "depth") report << s.maxDepth << " plies";
+                else report << s.thinkTime << " s";
+                report << "), " << threads << " thread" << (threads > 1 ? "s" : "") << " ==\n";
+                runs.push_back(RunSuite(positions, s, m, report));
+            }
+        }
+
+        if (jsonFile == "-") {
+            WriteJson(cout, runs, settings);
+        } else {
+            ofstream out(jsonFile);
+            if (!out) throw runtime_error("Cannot write " + jsonFile);
+            WriteJson(out, runs, settings);
+            report << "\nResults written to " << jsonFile << "\n";
+        }
+    } catch (const exception& e) {
+        cerr << "bench: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,201 @@
+// Opening book builder
+//
+// Collects opening positions - every position within --plies moves of the
+// start, every position along the lines of an openings file, and positions
+// played at least --min-count times in self-play training files (selfplay
+// --record) or game record files (selfplay --save-games, the game's games.bin) -
+// searches each one and writes the best moves as a book (see src/book.h).
+// Symmetric copies of a position are searched and stored once.
+//
+//   book [--plies N] [--openings FILE] [--records FILE]... [--games FILE]... [--record-plies N]
+//        [--min-count N] [--time SECONDS] [--depth N] [--jobs N]
+//        [--extend BOOK] [--out BOOK]
+//
+// --extend keeps the entries of an existing book and only searches new positions.
+#include "player.h"
+#include "book.h"
+#include "game_record.h"
+#include "openings.h"
+#include "thread_pool.h"
+#include "training_data.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Canonical orientation of every position to search, by canonical key
+typedef unordered_map<uint64_t, Position> PositionSet;
+
+static void AddPosition(PositionSet& set, const Position& pos) {
+    if (pos.LegalMoves() == 0) return;      // Nothing to choose
+    int s;
+    uint64_t key = CanonicalKey(pos, s);
+    if (!set.count(key)) set[key] = TransformPosition(pos, s);
+}
+
+// Every position within plies moves of the start
+static void AddTree(PositionSet& set, Position& pos, int plies) {
+    AddPosition(set, pos);
+    if (plies == 0) return;
+    for (uint64_t moves = pos.LegalMoves(); moves; moves &= moves - 1) {
+        int sq = LowestBit(moves);
+        Position child = pos;
+        child.MakeMove(sq);
+        if (child.LegalMoves() == 0 && !child.IsGameOver()) child.Pass();
+        AddTree(set, child, plies - 1);
+    }
+}
+
+// Every position along each line, including the final one
+static void AddLines(PositionSet& set, const string& path) {
+    for (const Opening& o : LoadOpenings(path)) {
+        string moves;
+        for (char c : o.moves)
+            if (c != ' ' && c != '\t' && c != '\r') moves += c;
+        for (size_t n = 0; n <= moves.size(); n += 2) AddPosition(set, PlayMoves(moves.substr(0, n)));
+    }
+}
+
+// Times each canonical position was seen in training or game records
+typedef unordered_map<uint64_t, int> PositionCounts;
+
+// Early positions of training records that occur at least minCount times
+static void AddRecords(PositionSet& set, PositionCounts& counts, const vector<string>& paths, int plies, int minCount) {
+    for (const string& path : paths) {
+        MappedFile file;
+        file.Open(path, true);
+        size_t count;
+        const TrainingRecord* records = TrainingRecords(file.Data(), file.Size(), count);
+        for (size_t i = 0; i < count; i++) {
+            Position pos;
+            pos.bits.black = records[i].black;
+            pos.bits.white = records[i].white;
+            pos.currentPlayer = (Cell)records[i].side;
+            if (PopCount(pos.bits.Empty()) < 60 - plies) continue;
+            pos.hash = pos.ComputeHash();
+            if (++counts[CanonicalKey(pos)] == minCount) AddPosition(set, pos);
+        }
+    }
+}
+
+// Positions within the first plies moves of recorded games that occur at least
+// minCount times
+static void AddGames(PositionSet& set, PositionCounts& counts, const vector<string>& paths, int plies, int minCount) {
+    for (const string& path : paths) {
+        GameReader reader(path);
+        GameView game;
+        while (reader.Next(game)) {
+            Position pos;
+            for (int i = 0; i < game.MoveCount() && i < plies; i++) {
+                if (game.moves[i] == MOVE_PASS) {
+                    pos.Pass();
+                    continue;
+                }
+                if (game.moves[i] >= 64 || !(pos.LegalMoves() & (1ULL << game.moves[i]))) break;
+                if (++counts[CanonicalKey(pos)] == minCount) AddPosition(set, pos);
+                pos.MakeMove(game.moves[i]);
+            }
+        }
+        if (reader.BadBlocks()) cerr << path << ": skipped " << reader.BadBlocks() << " damaged blocks\n";
+    }
+}
+
+static void Usage() {
+    cerr << "usage: book [--plies N] [--openings FILE] [--records FILE]... [--games FILE]... [--record-plies N]\n"
+            "            [--min-count N] [--time SECONDS] [--depth N] [--jobs N]\n"
+            "            [--extend BOOK] [--out BOOK]\n";
+}
+
+int main(int argc, char** argv) {
+    int plies = 6;
+    string openingsFile;
+    vector<string> recordFiles, gameFiles;
+    int recordPlies = 16;
+    int minCount = 4;
+    int jobs = 0;
+    string extendFile, outFile = "book.bin";
+    AISettings settings;
+    settings.thinkTime = 1.0;
+    settings.threads = 1;       // One search per worker thread
+    settings.ttSizeMB = 8;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--plies" && hasValue) plies = atoi(argv[++i]);
+            else if (arg == "--openings" && hasValue) openingsFile = argv[++i];
+            else if (arg == "--records" && hasValue) recordFiles.push_back(argv[++i]);
+            else if (arg == "--games" && hasValue) gameFiles.push_back(argv[++i]);
+            else if (arg == "--record-plies" && hasValue) recordPlies = atoi(argv[++i]);
+            else if (arg == "--min-count" && hasValue) minCount = atoi(argv[++i]);
+            else if (arg == "--time" && hasValue) settings.thinkTime = atof(argv[++i]);
+            else if (arg == "--depth" && hasValue) settings.maxDepth = atoi(argv[++i]);
+            else if (arg == "--jobs" && hasValue) jobs = atoi(argv[++i]);
+            else if (arg == "--extend" && hasValue) extendFile = argv[++i];
+            else if (arg == "--out" && hasValue) outFile = argv[++i];
+            else { Usage(); return 1; }
+        }
+
+        PositionSet set;
+        Position start;
+        if (plies >= 0) AddTree(set, start, plies);
+        if (!openingsFile.empty()) AddLines(set, openingsFile);
+        PositionCounts counts;
+        if (!recordFiles.empty()) AddRecords(set, counts, recordFiles, recordPlies, max(minCount, 1));
+        if (!gameFiles.empty()) AddGames(set, counts, gameFiles, recordPlies, max(minCount, 1));
+
+        vector<BookEntry> entries;
+        if (!extendFile.empty()) {
+            OpeningBook old(extendFile);
+            entries.assign(old.begin(), old.end());
+            for (const BookEntry& e : entries) set.erase(e.key);
+            cerr << "Kept " << entries.size() << " entries of " << extendFile << "\n";
+        }
+
+        vector<pair<uint64_t, Position>> todo(set.begin(), set.end());
+        ThreadPool pool(jobs);
+        mutex entriesMutex;
+        atomic<size_t> finished{0};
+        auto begin = chrono::steady_clock::now();
+        cerr << "Searching " << todo.size() << " positions on " << pool.Size() << " threads\n";
+
+        // One engine per worker, each taking every pool.Size()-th position
+        for (int t = 0; t < pool.Size(); t++) {
+            pool.Submit([&, t]() {
+                AIPlayer engine(settings);
+                for (size_t i = t; i < todo.size(); i += pool.Size()) {
+                    engine.NewGame();
+                    int move = engine.Search(todo[i].second);
+                    const SearchStats& stats = engine.LastStats();
+                    BookEntry e;
+                    e.key = todo[i].first;
+                    e.score = stats.score;
+                    e.move = (uint8_t)move;
+                    e.depth = (uint8_t)min(stats.depth, 255);
+                    e.reserved = 0;
+
+                    lock_guard<mutex> lock(entriesMutex);
+                    entries.push_back(e);
+                    size_t done = ++finished;
+                    if (done % 100 == 0) cerr << done << "/" << todo.size() << " positions\r" << flush;
+                }
+            });
+        }
+        pool.Wait();
+
+        WriteBook(outFile, entries);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        cerr << "\n" << entries.size() << " entries (" << entries.size() * sizeof(BookEntry) / 1024
+             << " KB) written to " << outFile << " in " << seconds << " s\n";
+    } catch (const exception& e) {
+        cerr << "book: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,182 @@
+// Crash-recovery checks for the on-disk logs
+//
+// Writes game record and score files into the current directory, damages them
+// the way a crash mid-write would (a torn last block or record, a torn file
+// header, and a torn block written after by an older writer) and checks that
+// every whole game can still be read and that later appends are not lost.
+//
+//   filetest                       run the checks, exit 1 on any failure
+#include "game_record.h"
+#include "score_store.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>     // For istreambuf_iterator
+#include <stdexcept>
+#include <string>
+using namespace std;
+
+static const char* const TEST_FILE = "filetest.tmp";
+static const char* const TEST_FILE_2 = "filetest2.tmp";
+static const char* const TEST_TEXT = "filetest.txt.tmp";
+
+static size_t FileSize(const string& path) {
+    ifstream in(path, ios::binary | ios::ate);
+    return in ? (size_t)(streamoff)in.tellg() : 0;
+}
+
+static string ReadAll(const string& path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+static void WriteAll(const string& path, const string& data) {
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(data.data(), (streamsize)data.size());
+}
+
+// Append count games, each flushed as its own block as Game::SaveGame does
+static void AppendGames(const string& path, int count, int64_t firstTime) {
+    static const char* const LINES[] = {"f5d6c3d3c4", "f5f6e6f4", "d3c5f6f5e6e3", "c4e3f6e6f5"};
+    GameWriter writer(path);
+    for (int i = 0; i < count; i++) {
+        writer.Append(ParseMoveList(LINES[i % 4]), 6, 3, SOURCE_SELFPLAY, firstTime + i);
+        writer.Flush();
+    }
+}
+
+// Games read back and bad blocks skipped; every game must replay
+static void ReadGames(const string& path, size_t& games, size_t& badBlocks) {
+    GameReader reader(path);
+    GameView game;
+    games = 0;
+    while (reader.Next(game)) {
+        game.PositionAfter(game.MoveCount());      // Throws on a garbled game
+        games++;
+    }
+    badBlocks = reader.BadBlocks();
+}
+
+static bool Report(const char* name, size_t games, size_t badBlocks, size_t expectGames, size_t expectBad) {
+    bool ok = games == expectGames && badBlocks == expectBad;
+    printf("%-28s %2zu games, %zu bad blocks  %s", name, games, badBlocks, ok ? "ok" : "FAIL");
+    if (!ok) printf(" (expected %zu games, %zu bad blocks)", expectGames, expectBad);
+    printf("\n");
+    return ok;
+}
+
+// A crash tore the last block; a new writer must cut it off before appending
+static bool AppendAfterTornBlock() {
+    remove(TEST_FILE);
+    AppendGames(TEST_FILE, 2, 100);
+    WriteAll(TEST_FILE, ReadAll(TEST_FILE).substr(0, FileSize(TEST_FILE) - 4));
+    AppendGames(TEST_FILE, 5, 200);
+    size_t games, bad;
+    ReadGames(TEST_FILE, games, bad);
+    return Report("append after torn block", games, bad, 6, 0);
+}
+
+// A crash tore the file header of a new file; the writer starts it over
+static bool AppendAfterTornHeader() {
+    remove(TEST_FILE);
+    WriteAll(TEST_FILE, string(GAME_FILE_MAGIC, 5));
+    AppendGames(TEST_FILE, 3, 100);
+    size_t games, bad;
+    ReadGames(TEST_FILE, games, bad);
+    return Report("append after torn header", games, bad, 3, 0);
+}
+
+// A file damaged by a writer without the cut: a torn block with games appended
+// after it. The reader must skip just that block.
+static bool ReadPastTornBlock() {
+    remove(TEST_FILE);
+    remove(TEST_FILE_2);
+    AppendGames(TEST_FILE, 2, 100);
+    AppendGames(TEST_FILE_2, 5, 200);
+    string torn = ReadAll(TEST_FILE);
+    torn.resize(torn.size() - 4);
+    WriteAll(TEST_FILE, torn + ReadAll(TEST_FILE_2).substr(sizeof(GameFileHeader)));
+    size_t games, bad;
+    ReadGames(TEST_FILE, games, bad);
+    remove(TEST_FILE_2);
+    return Report("read past torn block", games, bad, 6, 1);
+}
+
+static ScoreRecord Score(int64_t time, int black, int white) {
+    ScoreRecord r = {};
+    r.time = time;
+    r.black = (uint8_t)black;
+    r.white = (uint8_t)white;
+    r.result = black > white ? BLACK_WINS : white > black ? WHITE_WINS : DRAW;
+    r.mode = MODE_VS_AI;
+    return r;
+}
+
+static bool ReportScores(const char* name, const ScoreStore& store, size_t expectGames) {
+    bool ok = store.Size() == expectGames && FileSize(TEST_FILE) == sizeof(ScoreHeader) + expectGames * sizeof(ScoreRecord);
+    printf("%-28s %2zu games, %zu bytes  %s", name, store.Size(), FileSize(TEST_FILE), ok ? "ok" : "FAIL");
+    if (!ok) printf(" (expected %zu games)", expectGames);
+    printf("\n");
+    return ok;
+}
+
+// A score file created but never written is started over
+static bool ScoresAfterEmptyFile() {
+    WriteAll(TEST_FILE, "");
+    ScoreStore store;
+    store.Open(TEST_FILE);
+    store.Append(Score(100, 40, 24));
+    ScoreStore reopened;
+    reopened.Open(TEST_FILE);
+    return ReportScores("scores after empty file", reopened, 1);
+}
+
+// A crash while writing the header of a new score file: the header is written
+// again and the legacy text history imported
+static bool ScoresAfterTornHeader() {
+    WriteAll(TEST_FILE, string(SCORE_MAGIC, 7));
+    WriteAll(TEST_TEXT, "[2024-05-01 12:00:00] Black: 40 | White: 24 | Winner: Black\n");
+    ScoreStore store;
+    store.Open(TEST_FILE, TEST_TEXT);
+    store.Append(Score(2000000000, 30, 34));
+    ScoreStore reopened;
+    reopened.Open(TEST_FILE);
+    remove(TEST_TEXT);
+    return ReportScores("scores after torn header", reopened, 2);
+}
+
+// A crash mid-append tore the last record; later appends must stay aligned
+static bool ScoresAfterTornRecord() {
+    remove(TEST_FILE);
+    {
+        ScoreStore store;
+        store.Open(TEST_FILE);
+        store.Append(Score(100, 40, 24));
+        store.Append(Score(200, 20, 44));
+    }
+    WriteAll(TEST_FILE, ReadAll(TEST_FILE).substr(0, FileSize(TEST_FILE) - 5));
+    ScoreStore store;
+    store.Open(TEST_FILE);
+    store.Append(Score(300, 32, 32));
+    ScoreStore reopened;
+    reopened.Open(TEST_FILE);
+    bool ok = ReportScores("scores after torn record", reopened, 2);
+    return ok && reopened.Page(0, 1)[0].time == 300;
+}
+
+int main() {
+    int failures = 0, cases = 0;
+    for (bool (*check)() : {AppendAfterTornBlock, AppendAfterTornHeader, ReadPastTornBlock,
+                            ScoresAfterEmptyFile, ScoresAfterTornHeader, ScoresAfterTornRecord}) {
+        cases++;
+        try {
+            if (!check()) failures++;
+        } catch (const exception& e) {
+            printf("FAIL: %s\n", e.what());
+            failures++;
+        }
+    }
+    remove(TEST_FILE);
+    remove(TEST_TEXT);
+    printf("%d/%d passed\n", cases - failures, cases);
+    return failures == 0 ? 0 : 1;
+}
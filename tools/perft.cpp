@@ -0,0 +1,302 @@
+// Move-generation benchmark and correctness suite
+//
+// Counts the leaf nodes of the full game tree to a fixed depth and compares
+// them with reference values. A pass counts as a ply; a finished game counts
+// as a single leaf wherever it occurs, which is the convention the published
+// Othello perft tables use. The suite also counts every position in its 7 other
+// orientations, which checks the board symmetry transforms and canonical keys,
+// and cross-checks every move-generation kernel the CPU can run against the
+// portable one on the positions of random games. Stored positions with more
+// than 32 legal moves are also searched to a fixed depth.
+//
+//   perft                          run the suite, report nodes/s, exit 1 on any mismatch
+//   perft --depth N                count the start position (or --board) to depth N
+//   perft --board "BOARD"          count a position given as 64 cells + side to move
+//   perft --moves "f5d6c3"         count the position after a move sequence
+#include "position.h"
+#include "openings.h"
+#include "symmetry.h"
+#include "search.h"
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+// P = side to move, O = opponent; passed = the previous ply was a pass
+static uint64_t Perft(const MoveKernels& k, uint64_t P, uint64_t O, int depth, bool passed = false) {
+    uint64_t moves = k.moves(P, O);
+    if (moves == 0) {
+        if (passed || k.moves(O, P) == 0) return 1;    // Game over
+        return depth == 1 ? 1 : Perft(k, O, P, depth - 1, true);
+    }
+    // Bulk count: every legal move is one leaf at the last ply
+    if (depth == 1) return PopCount(moves);
+
+    uint64_t nodes = 0;
+    while (moves) {
+        int sq = LowestBit(moves);
+        moves &= moves - 1;
+        uint64_t flips = k.flips(P, O, sq);
+        nodes += Perft(k, O & ~flips, P | flips | (1ULL << sq), depth - 1);
+    }
+    return nodes;
+}
+
+static uint64_t Perft(const Position& pos, int depth, const MoveKernels& k = ACTIVE_KERNELS) {
+    if (depth <= 0) return 1;
+    uint64_t P = pos.bits.Discs(pos.currentPlayer);
+    uint64_t O = pos.bits.Discs(Opponent(pos.currentPlayer));
+    return Perft(k, P, O, depth);
+}
+
+struct PerftCase {
+    const char* name;
+    const char* board;
+    int depth;
+    uint64_t nodes;
+};
+
+static const char* START_BOARD =
+    "---------------------------OX------XO--------------------------- X";
+
+// Reference counts; the stored positions were counted with an independent
+// square-by-square move generator
+static const PerftCase SUITE[] = {
+    {"start",     START_BOARD, 1, 4},
+    {"start",     START_BOARD, 2, 12},
+    {"start",     START_BOARD, 3, 56},
+    {"start",     START_BOARD, 4, 244},
+    {"start",     START_BOARD, 5, 1396},
+    {"start",     START_BOARD, 6, 8200},
+    {"start",     START_BOARD, 7, 55092},
+    {"start",     START_BOARD, 8, 390216},
+    {"start",     START_BOARD, 9, 3005288},
+    {"start",     START_BOARD, 10, 24571284},
+    {"midgame",   "-X--------XO-----OOOOX----OOXXXX-X-OOXO---OX-OOX---------------- X", 6, 5388302},
+    // Black has no move and must pass at the root
+    {"pass",      "O---X---OXXXXX--OXXXX---OOXXXX--OOOOX---OOOXX---OXXXX----X-XXX-- X", 6, 21980},
+    // Twelve empties to the end of the game, with passes inside the tree
+    {"endgame",   "O---O----OOOO----OOOOXXXXOXOOOOOXXXOXXOOOXXXXOOOOOXXOXOOO-XOOOOO X", 8, 768702},
+    {"endgame",   "O---O----OOOO----OOOOXXXXOXOOOOOXXXOXXOOOXXXXOOOOOXXOXOOO-XOOOOO X", 12, 9353349},
+    // 35 legal moves, more than any fixed 32-entry move list holds
+    {"wide",      "-OX------OXO--OO--OX--OX-X----OX-OXO--X--OXX-XO----OOXO--OX----- X", 4, 160746},
+    // Neither side can move: the position itself is the only leaf
+    {"game-over", "----------X-------X-----XXXXX-----XXX-----XXX-----X-------X----- O", 5, 1},
+};
+
+// Published values for the start position beyond the default suite
+static const uint64_t START_NODES[] = {
+    1, 4, 12, 56, 244, 1396, 8200, 55092, 390216, 3005288, 24571284,
+    212258800, 1939886636, 18429641748ULL,
+};
+static const int START_KNOWN = sizeof(START_NODES) / sizeof(START_NODES[0]) - 1;
+
+static double Seconds(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Count one position and print a result line; returns false on a mismatch
+static bool RunCase(const char* name, const Position& pos, int depth, uint64_t expected, bool check) {
+    auto start = chrono::steady_clock::now();
+    uint64_t nodes = Perft(pos, depth);
+    double seconds = Seconds(start);
+    bool ok = !check || nodes == expected;
+
+    printf("%-10s depth %2d  %14" PRIu64 " nodes  %8.3f s  %7.1f Mnodes/s", name, depth, nodes, seconds,
+           seconds > 0 ? nodes / seconds / 1e6 : 0.0);
+    if (check) printf("  %s", ok ? "ok" : "FAIL");
+    if (!ok) printf(" (expected %" PRIu64 ")", expected);
+    printf("\n");
+    return ok;
+}
+
+// Every rotation and reflection of pos must give the same count to depth and the
+// same canonical key, and its legal moves must map back onto those of pos
+static bool RunSymmetryCase(const char* name, const Position& pos, int depth) {
+    auto start = chrono::steady_clock::now();
+    uint64_t expected = Perft(pos, depth), nodes = expected;
+    uint64_t key = CanonicalKey(pos);
+    bool ok = true;
+    for (int s = 1; s < SYMMETRIES; s++) {
+        Position t = TransformPosition(pos, s);
+        uint64_t n = Perft(t, depth);
+        nodes += n;
+        ok &= n == expected && CanonicalKey(t) == key;
+        ok &= TransformBits(t.LegalMoves(), InverseSymmetry(s)) == pos.LegalMoves();
+    }
+    double seconds = Seconds(start);
+    printf("%-10s depth %2d  %14" PRIu64 " nodes  %8.3f s  %7.1f Mnodes/s  x8 symmetries %s\n", name, depth, nodes,
+           seconds, seconds > 0 ? nodes / seconds / 1e6 : 0.0, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+// Moves of both sides and the flips of every empty square must agree with the
+// portable kernels in every position of random games (fixed seed)
+static bool CheckKernels(const MoveKernels& k, int games) {
+    const MoveKernels ref = UsableKernels().front();
+    mt19937_64 rng(20240611);
+    uint64_t positions = 0;
+    for (int g = 0; g < games; g++) {
+        Position pos;
+        while (!pos.IsGameOver()) {
+            uint64_t P = pos.bits.Discs(pos.currentPlayer);
+            uint64_t O = pos.bits.Discs(Opponent(pos.currentPlayer));
+            positions++;
+            if (k.moves(P, O) != ref.moves(P, O) || k.moves(O, P) != ref.moves(O, P)) {
+                printf("%-10s moves differ in %s\n", k.name, BoardString(pos).c_str());
+                return false;
+            }
+            for (uint64_t e = ~(P | O); e; e &= e - 1) {
+                int sq = LowestBit(e);
+                if (k.flips(P, O, sq) != ref.flips(P, O, sq) || k.flips(O, P, sq) != ref.flips(O, P, sq)) {
+                    printf("%-10s flips on %s differ in %s\n", k.name, SquareName(sq).c_str(), BoardString(pos).c_str());
+                    return false;
+                }
+            }
+            uint64_t moves = pos.LegalMoves();
+            if (moves == 0) {
+                pos.Pass();
+                continue;
+            }
+            int pick = (int)(rng() % PopCount(moves));
+            while (pick--) moves &= moves - 1;
+            pos.MakeMove(LowestBit(moves));
+        }
+    }
+    printf("%-10s %" PRIu64 " random positions agree with %s\n", k.name, positions, ref.name);
+    return true;
+}
+
+// A fixed-depth search of pos must complete and return a legal move and a legal
+// PV; positions with many moves check the search's move lists
+static bool RunSearchCase(const char* name, const Position& pos, int depth) {
+    TranspositionTable tt(1);
+    SearchShared shared;
+    shared.tt = &tt;
+    shared.maxDepth = depth;
+    shared.start = Clock::now();
+    shared.deadline = shared.start + chrono::hours(1);
+    SearchThread search(shared, true);
+    search.Run(pos, 0, 0);
+
+    bool ok = search.completedDepth == depth && !search.pv.empty();
+    Position line = pos;
+    for (int move : search.pv) {
+        if (!ok) break;
+        if (move == NO_MOVE) {
+            ok = line.LegalMoves() == 0;
+            line.Pass();
+        } else {
+            ok = (line.LegalMoves() >> move) & 1;
+            line.MakeMove(move);
+        }
+    }
+    printf("%-10s search depth %d: %2d moves, best %s, %" PRIu64 " nodes  %s\n", name, depth,
+           PopCount(pos.LegalMoves()), SquareName(search.bestRootMove).c_str(), search.nodes, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static void Usage() {
+    cerr << "usage: perft [--depth N] [--board \"BOARD\" | --moves MOVES]\n"
+            "BOARD: 64 cells from a1 to h8 ('X', 'O', '-') then the side to move, e.g.\n"
+            "       \"" << START_BOARD << "\"\n";
+}
+
+int main(int argc, char** argv) {
+    int depth = 0;
+    string board, moves;
+    bool custom = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--depth" && hasValue) depth = atoi(argv[++i]);
+        else if (arg == "--board" && hasValue) board = argv[++i];
+        else if (arg == "--moves" && hasValue) moves = argv[++i];
+        else { Usage(); return 1; }
+        custom = true;
+    }
+
+    // Single position mode
+    if (custom) {
+        Position pos;
+        bool start = board.empty() && moves.empty();
+        try {
+            if (!board.empty() && !ParseBoard(board, pos)) throw runtime_error("Bad board '" + board + "'");
+            if (!moves.empty()) pos = PlayMoves(moves);
+        } catch (const exception& e) {
+            cerr << "perft: " << e.what() << "\n";
+            return 1;
+        }
+        if (depth <= 0) depth = 8;
+        bool known = start && depth <= START_KNOWN;
+        cout << BoardString(pos) << "\n";
+        return RunCase(start ? "start" : "position", pos, depth, known ? START_NODES[depth] : 0, known) ? 0 : 1;
+    }
+
+    // Suite mode
+    printf("move kernels: %s (usable:", ACTIVE_KERNELS.name);
+    for (const MoveKernels& k : UsableKernels()) printf(" %s", k.name);
+    printf(")\n");
+    int failures = 0, cases = 0;
+    uint64_t totalNodes = 0;
+    auto start = chrono::steady_clock::now();
+    for (const PerftCase& test : SUITE) {
+        cases++;
+        Position pos;
+        if (!ParseBoard(test.board, pos)) {
+            printf("%-10s bad board\n", test.name);
+            failures++;
+            continue;
+        }
+        if (!RunCase(test.name, pos, test.depth, test.nodes, true)) failures++;
+        totalNodes += test.nodes;
+    }
+    // Each stored position once, at a depth that keeps the x8 cost small
+    const int SYMMETRY_DEPTH = 6;
+    for (size_t i = 0; i < sizeof(SUITE) / sizeof(SUITE[0]); i++) {
+        if (i > 0 && strcmp(SUITE[i].board, SUITE[i - 1].board) == 0) continue;
+        Position pos;
+        if (!ParseBoard(SUITE[i].board, pos)) continue;
+        if (!RunSymmetryCase(SUITE[i].name, pos, SYMMETRY_DEPTH)) failures++;
+        cases++;
+    }
+    // Searching the widest stored positions must stay inside the move lists
+    for (const PerftCase& test : SUITE) {
+        Position pos;
+        if (!ParseBoard(test.board, pos) || PopCount(pos.LegalMoves()) <= 32) continue;
+        if (!RunSearchCase(test.name, pos, 4)) failures++;
+        cases++;
+    }
+    // Every kernel set this CPU runs must count the same tree and match the
+    // portable kernels position by position
+    const int KERNEL_DEPTH = 9, KERNEL_GAMES = 2000;
+    Position startPos;
+    ParseBoard(START_BOARD, startPos);
+    vector<MoveKernels> kernels = UsableKernels();
+    for (const MoveKernels& k : kernels) {
+        auto kernelStart = chrono::steady_clock::now();
+        uint64_t nodes = Perft(startPos, KERNEL_DEPTH, k);
+        double kernelSeconds = Seconds(kernelStart);
+        bool ok = nodes == START_NODES[KERNEL_DEPTH];
+        printf("%-10s depth %2d  %14" PRIu64 " nodes  %8.3f s  %7.1f Mnodes/s  %s\n", k.name, KERNEL_DEPTH, nodes,
+               kernelSeconds, kernelSeconds > 0 ? nodes / kernelSeconds / 1e6 : 0.0, ok ? "ok" : "FAIL");
+        if (!ok) failures++;
+        cases++;
+    }
+    for (size_t i = 1; i < kernels.size(); i++) {
+        if (!CheckKernels(kernels[i], KERNEL_GAMES)) failures++;
+        cases++;
+    }
+    double seconds = Seconds(start);
+    printf("%d/%d passed, %" PRIu64 " nodes in %.2f s (%.1f Mnodes/s)\n",
+           cases - failures, cases,
+           totalNodes, seconds, totalNodes / seconds / 1e6);
+    return failures == 0 ? 0 : 1;
+}
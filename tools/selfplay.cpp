@@ -0,0 +1,233 @@
+// Headless engine-vs-engine match runner
+//
+// Plays every opening twice (once with each engine on each colour) across a
+// thread pool and reports win/draw/loss for engine A with an Elo estimate.
+//
+//   selfplay [--games N] [--jobs N] [--openings FILE | --opening-plies N [--distinct-openings]]
+//            [--engine-a SPEC] [--engine-b SPEC] [--record FILE] [--save-games FILE] [--verbose]
+//
+// SPEC is a comma-separated list of time=SECONDS, depth=N, threads=N, tt=MB,
+// solve=EMPTIES, weights=FILE, book=FILE, canonical=0|1, e.g. "time=0.05,depth=8,solve=14".
+// canonical=1 keys the transposition table by symmetry-reduced positions.
+//
+// --distinct-openings drops enumerated openings that are rotations or mirror
+// images of another one (they would replay the same games).
+//
+// --record appends every position of every game, labelled with the game's
+// final disc differential, to a training file for the train tool.
+//
+// --save-games appends the full move list of every game, opening moves and
+// passes included, to a game record file (see game_record.h).
+#include "player.h"
+#include "book.h"
+#include "game_record.h"
+#include "openings.h"
+#include "thread_pool.h"
+#include "training_data.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Engine defaults for batch play: short moves, one search thread, small table
+static AISettings DefaultMatchSettings() {
+    AISettings s;
+    s.thinkTime = 0.1;
+    s.threads = 1;
+    s.ttSizeMB = 4;
+    return s;
+}
+
+// Weight files named in engine specs; kept for the whole run
+static const EvalWeights* LoadWeights(const string& path) {
+    static list<EvalWeights> loaded;
+    loaded.push_back(EvalWeights::Load(path));
+    return &loaded.back();
+}
+
+// Opening books named in engine specs; kept for the whole run
+static const OpeningBook* LoadBook(const string& path) {
+    static list<OpeningBook> loaded;
+    loaded.emplace_back(path);
+    return &loaded.back();
+}
+
+// Apply "key=value,key=value" overrides to settings
+static AISettings ParseSettings(const string& spec, AISettings s) {
+    stringstream ss(spec);
+    string item;
+    while (getline(ss, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == string::npos) throw runtime_error("Bad engine setting '" + item + "'");
+        string key = item.substr(0, eq);
+        double value = atof(item.c_str() + eq + 1);
+        if (key == "weights") s.weights = LoadWeights(item.substr(eq + 1));
+        else if (key == "book") s.book = LoadBook(item.substr(eq + 1));
+        else if (key == "canonical") s.canonicalTT = value != 0;
+        else if (key == "time") s.thinkTime = value;
+        else if (key == "depth") s.maxDepth = (int)value;
+        else if (key == "threads") s.threads = (int)value;
+        else if (key == "tt") s.ttSizeMB = (size_t)value;
+        else if (key == "solve") s.solveEmpties = (int)value;
+        else throw runtime_error("Unknown engine setting '" + key + "'");
+    }
+    return s;
+}
+
+// Play one game to the end; returns Black's disc differential. Positions with a
+// move to play are added to history and the moves played (passes as MOVE_PASS)
+// to moves when they are given.
+static int PlayGame(Position pos, AIPlayer& black, AIPlayer& white, vector<Position>* history = nullptr,
+                    vector<uint8_t>* moves = nullptr) {
+    black.NewGame();
+    white.NewGame();
+    while (!pos.IsGameOver()) {
+        if (pos.LegalMoves() == 0) {
+            pos.Pass();
+            if (moves) moves->push_back(MOVE_PASS);
+            continue;
+        }
+        if (history) history->push_back(pos);
+        AIPlayer& mover = (pos.currentPlayer == Black_Disc) ? black : white;
+        int move = mover.Search(pos);
+        pos.MakeMove(move);
+        if (moves) moves->push_back((uint8_t)move);
+    }
+    return PopCount(pos.bits.black) - PopCount(pos.bits.white);
+}
+
+// Elo difference for a score fraction in (0, 1)
+static double EloFromScore(double score) {
+    return -400.0 * log10(1.0 / score - 1.0);
+}
+
+static void Usage() {
+    cerr << "usage: selfplay [--games N] [--jobs N] [--openings FILE | --opening-plies N [--distinct-openings]]\n"
+            "                [--engine-a SPEC] [--engine-b SPEC] [--record FILE] [--save-games FILE] [--verbose]\n"
+            "SPEC: time=SECONDS,depth=N,threads=N,tt=MB,solve=EMPTIES,weights=FILE,book=FILE,canonical=0|1\n";
+}
+
+int main(int argc, char** argv) {
+    int games = 0;                  // 0 = each opening twice
+    int jobs = 0;                   // 0 = one game per core at a time
+    int openingPlies = 4;
+    string openingsFile;
+    bool distinctOpenings = false;
+    string recordFile;
+    string gamesFile;
+    bool verbose = false;
+    AISettings engineA = DefaultMatchSettings();
+    AISettings engineB = DefaultMatchSettings();
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--games" && hasValue) games = atoi(argv[++i]);
+            else if (arg == "--jobs" && hasValue) jobs = atoi(argv[++i]);
+            else if (arg == "--openings" && hasValue) openingsFile = argv[++i];
+            else if (arg == "--opening-plies" && hasValue) openingPlies = atoi(argv[++i]);
+            else if (arg == "--distinct-openings") distinctOpenings = true;
+            else if (arg == "--engine-a" && hasValue) engineA = ParseSettings(argv[++i], engineA);
+            else if (arg == "--engine-b" && hasValue) engineB = ParseSettings(argv[++i], engineB);
+            else if (arg == "--record" && hasValue) recordFile = argv[++i];
+            else if (arg == "--save-games" && hasValue) gamesFile = argv[++i];
+            else if (arg == "--verbose") verbose = true;
+            else { Usage(); return 1; }
+        }
+
+        vector<Opening> openings = openingsFile.empty() ? EnumerateOpenings(openingPlies, distinctOpenings) : LoadOpenings(openingsFile);
+        if (openings.empty()) throw runtime_error("No openings");
+        if (games <= 0) games = 2 * (int)openings.size();
+
+        atomic<int> wins{0}, draws{0}, losses{0}, finished{0};
+        mutex outputMutex;
+        unique_ptr<TrainingWriter> record;
+        if (!recordFile.empty()) record.reset(new TrainingWriter(recordFile));
+        unique_ptr<GameWriter> gameLog;
+        if (!gamesFile.empty()) gameLog.reset(new GameWriter(gamesFile));
+        ThreadPool pool(jobs);
+        auto start = chrono::steady_clock::now();
+
+        cerr << "Playing " << games << " games from " << openings.size() << " openings on "
+             << pool.Size() << " threads\n";
+
+        // Game i plays opening i/2; engine A has Black in even games and White in odd ones
+        for (int i = 0; i < games; i++) {
+            pool.Submit([&, i]() {
+                const Opening& opening = openings[(i / 2) % openings.size()];
+                bool aIsBlack = (i % 2) == 0;
+                AIPlayer a(engineA), b(engineB);
+                vector<Position> history;
+                vector<Position>* positions = record ? &history : nullptr;
+                vector<uint8_t> moves;
+                if (gameLog) moves = ParseMoveList(opening.moves);
+                vector<uint8_t>* played = gameLog ? &moves : nullptr;
+                int diff = aIsBlack ? PlayGame(opening.pos, a, b, positions, played)
+                                    : PlayGame(opening.pos, b, a, positions, played);
+                int aDiff = aIsBlack ? diff : -diff;
+
+                if (aDiff > 0) wins++;
+                else if (aDiff < 0) losses++;
+                else draws++;
+                int done = ++finished;
+
+                lock_guard<mutex> lock(outputMutex);
+                for (const Position& p : history) record->Append(p, diff);
+                if (gameLog) {
+                    Position end = ReplayMoves(moves.data(), moves.size());
+                    gameLog->Append(moves, PopCount(end.bits.black), PopCount(end.bits.white),
+                                    SOURCE_SELFPLAY, (int64_t)time(nullptr));
+                }
+                if (verbose) {
+                    cout << "game " << i + 1 << " " << (opening.moves.empty() ? "-" : opening.moves)
+                         << " A=" << (aIsBlack ? "black" : "white") << " A-disc-diff " << aDiff << "\n";
+                }
+                if (done % 100 == 0) cerr << done << "/" << games << " games\r" << flush;
+            });
+        }
+        pool.Wait();
+        if (record) {
+            record->Flush();
+            cerr << "Training positions appended to " << recordFile << "\n";
+        }
+        if (gameLog) {
+            gameLog->Flush();
+            cerr << "Games appended to " << gamesFile << "\n";
+        }
+
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        int w = wins, d = draws, l = losses;
+        int n = w + d + l;
+        double score = (w + 0.5 * d) / n;
+
+        // 95% interval from the per-game score variance
+        double variance = (w * pow(1.0 - score, 2) + d * pow(0.5 - score, 2) + l * pow(score, 2)) / n;
+        double margin = 1.96 * sqrt(variance / n);
+        double low = max(score - margin, 1e-6), high = min(score + margin, 1 - 1e-6);
+
+        printf("\nEngine A vs engine B: %d games in %.1f s (%.1f games/s)\n", n, seconds, n / seconds);
+        printf("A: %d wins, %d draws, %d losses, score %.1f%%\n", w, d, l, 100.0 * score);
+        if (score <= 0 || score >= 1) {
+            printf("Elo difference: %s (no games %s)\n", score <= 0 ? "-inf" : "+inf", score <= 0 ? "won" : "lost");
+        } else {
+            printf("Elo difference: %+.1f (95%%: %+.1f to %+.1f)\n",
+                   EloFromScore(score), EloFromScore(low), EloFromScore(high));
+        }
+    } catch (const exception& e) {
+        cerr << "selfplay: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,558 @@
+// Engine server - many games in one process over a GTP-style text protocol
+//
+// Every connection (stdin/stdout, and each client of the Unix-domain socket) is
+// one game session with its own position, clock and engine. The engines share
+// one transposition table and their searches run on one thread pool, so a
+// session costs a few kilobytes instead of a process with its own table.
+//
+//   server [--socket PATH] [--no-stdin] [--jobs N] [--tt MB] [--time SECONDS]
+//          [--depth N] [--solve EMPTIES] [--weights FILE] [--book FILE]
+//
+// Commands follow GTP version 2: one per line, an optional numeric id first;
+// replies are "= result" or "? error" (with the id) followed by a blank line.
+// Moves are squares such as "f5" or "pass"; colours are "b"/"black" or
+// "w"/"white". Supported:
+//
+//   protocol_version, name, version, known_command, list_commands, quit,
+//   boardsize 8, clear_board, komi, play COLOR MOVE, genmove COLOR, undo,
+//   showboard, final_score, time_settings MAIN BYO_YOMI STONES,
+//   time_left COLOR SECONDS STONES, and the extensions set_board BOARD (perft's
+//   64-cell notation; starts a new game from that position), set_time SECONDS (per
+//   move without a clock), set_depth N
+//
+// A session's commands run in order: lines that arrive while its genmove is
+// searching wait for the reply. A session's time budget for a move counts from
+// the moment genmove arrived, so time spent queued behind other sessions'
+// searches is taken out of the search.
+#include "player.h"
+#include "book.h"
+#include "thread_pool.h"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+using namespace std;
+
+static const char* const COMMANDS[] = {
+    "protocol_version", "name", "version", "known_command", "list_commands", "quit",
+    "boardsize", "clear_board", "komi", "play", "genmove", "undo", "showboard", "final_score",
+    "time_settings", "time_left", "set_board", "set_time", "set_depth",
+};
+
+// One game: position, history for undo, clock and engine
+struct Session {
+    Position pos;
+    vector<Position> history;
+    unique_ptr<AIPlayer> engine;
+    double moveTime;                // Seconds per move without a clock
+    int maxDepth;
+    bool clock = false;             // time_settings given
+    double timeLeft = 0;            // Seconds on our clock (main time, or the byo-yomi period)
+    int stones = 0;                 // Moves left in the byo-yomi period, 0 in main time
+    double mainTime = 0;            // time_settings, for restarting the clock
+    double byoYomi = 0;
+    int byoStones = 0;
+
+    // Start the clock of a new game from the time_settings values
+    void ResetClock() {
+        clock = mainTime > 0 || byoStones > 0;
+        timeLeft = mainTime > 0 ? mainTime : byoYomi;
+        stones = mainTime > 0 ? 0 : byoStones;
+    }
+
+    // Seconds to spend on the next move
+    double Budget() const {
+        if (!clock) return moveTime;
+        double budget;
+        if (stones > 0) budget = timeLeft / stones;
+        else {
+            int ownMoves = max(1, (PopCount(pos.bits.Empty()) + 1) / 2);
+            budget = timeLeft / ownMoves;
+            if (byoStones > 0) budget = max(budget, byoYomi / byoStones);
+        }
+        return max(0.01, 0.9 * budget);     // Keep a margin for the reply to travel
+    }
+
+    // Take elapsed seconds off the clock after a move of ours
+    void Spend(double elapsed) {
+        if (!clock) return;
+        timeLeft -= elapsed;
+        if (stones > 0 && --stones == 0) {          // Period done: a fresh one
+            timeLeft = byoYomi;
+            stones = byoStones;
+        } else if (stones == 0 && timeLeft <= 0 && byoStones > 0) {     // Main time used up
+            timeLeft = byoYomi;
+            stones = byoStones;
+        }
+    }
+};
+
+struct Connection {
+    int inFd, outFd;
+    bool isSocket;
+    string input;                   // Bytes read but not yet a full line
+    deque<string> lines;            // Commands waiting for a running genmove
+    bool busy = false;              // genmove searching on the pool
+    bool inputDone = false;         // End of input: drop once the queued lines are answered
+    bool closed = false;            // Peer gone or quit: drop once not busy
+    Session session;
+};
+
+// Searches finished on the pool, handed back to the I/O loop
+struct Completion {
+    int id;
+    string reply;
+};
+
+class Server {
+    private:
+        AISettings settings;
+        TranspositionTable tt;
+        ThreadPool pool;
+        map<int, shared_ptr<Connection>> connections;
+        int nextId = 0;
+        int listenFd = -1;
+        int wakeRead = -1, wakeWrite = -1;      // Self-pipe: a completion is waiting
+        mutex completedMutex;
+        vector<Completion> completed;
+
+        static string Lower(string s) {
+            for (char& c : s) c = (char)tolower((unsigned char)c);
+            return s;
+        }
+
+        static bool ParseColor(const string& text, Cell& color) {
+            string c = Lower(text);
+            if (c == "b" || c == "black") color = Black_Disc;
+            else if (c == "w" || c == "white") color = White_Disc;
+            else return false;
+            return true;
+        }
+
+        static string ShowBoard(const Position& pos) {
+            string out;
+            for (int row = 0; row < BOARD_SIZE; row++) {
+                out += "\n" + string(1, (char)('1' + row)) + " ";
+                for (int col = 0; col < BOARD_SIZE; col++) {
+                    uint64_t bit = SquareBit(row, col);
+                    out += (pos.bits.black & bit) ? " X" : (pos.bits.white & bit) ? " O" : " -";
+                }
+            }
+            out += "\n   a b c d e f g h\n";
+            out += (pos.currentPlayer == Black_Disc ? "X" : "O") + string(" to move");
+            return out;
+        }
+
+        void NewEngine(Session& s) {
+            AISettings a = settings;
+            a.maxDepth = s.maxDepth;
+            s.engine.reset(new AIPlayer(a));
+        }
+
+        void Send(Connection& c, const string& text) {
+            size_t done = 0;
+            while (done < text.size()) {
+                ssize_t n = c.isSocket ? send(c.outFd, text.data() + done, text.size() - done, MSG_NOSIGNAL)
+                                       : write(c.outFd, text.data() + done, text.size() - done);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    c.closed = true;
+                    return;
+                }
+                done += (size_t)n;
+            }
+        }
+
+        static string Reply(const string& id, bool ok, const string& text) {
+            return string(ok ? "=" : "?") + id + (text.empty() ? "" : " " + text) + "\n\n";
+        }
+
+        // Play color's turn: a move, or a pass when it has none
+        static string PlayMove(Session& s, Cell color, const string& moveText) {
+            if (s.pos.IsGameOver()) return "game is over";
+            if (color != s.pos.currentPlayer) return "not this colour's turn";
+            string m = Lower(moveText);
+            s.history.push_back(s.pos);
+            if (m == "pass") {
+                if (s.pos.LegalMoves() != 0) {
+                    s.history.pop_back();
+                    return "illegal move";
+                }
+                s.pos.Pass();
+                return "";
+            }
+            int sq = ParseSquare(m);
+            if (sq < 0 || m.size() != 2 || !(s.pos.LegalMoves() & (1ULL << sq))) {
+                s.history.pop_back();
+                return "illegal move";
+            }
+            s.pos.MakeMove(sq);
+            return "";
+        }
+
+        // Search on the pool; the reply comes back through Completion
+        void GenMove(const shared_ptr<Connection>& c, int id, const string& replyId, Cell color) {
+            Session& s = c->session;
+            if (s.pos.IsGameOver()) {
+                Send(*c, Reply(replyId, false, "game is over"));
+                return;
+            }
+            if (color != s.pos.currentPlayer) {
+                Send(*c, Reply(replyId, false, "not this colour's turn"));
+                return;
+            }
+            c->busy = true;
+            auto arrived = Clock::now();
+            pool.Submit([this, c, id, replyId, arrived]() {
+                Session& s = c->session;
+                string reply;
+                if (s.pos.LegalMoves() == 0) {
+                    s.history.push_back(s.pos);
+                    s.pos.Pass();
+                    reply = Reply(replyId, true, "pass");
+                } else {
+                    double queued = chrono::duration<double>(Clock::now() - arrived).count();
+                    s.engine->SetThinkTime(max(0.005, s.Budget() - queued));
+                    int move = s.engine->Search(s.pos);
+                    s.history.push_back(s.pos);
+                    s.pos.MakeMove(move);
+                    reply = Reply(replyId, true, SquareName(move));
+                }
+                s.Spend(chrono::duration<double>(Clock::now() - arrived).count());
+                {
+                    lock_guard<mutex> lock(completedMutex);
+                    completed.push_back({id, reply});
+                }
+                char byte = 1;
+                if (write(wakeWrite, &byte, 1) < 0) {}      // Pipe full: the loop is waking anyway
+            });
+        }
+
+        // Run one command line; false when the session should close
+        bool Execute(const shared_ptr<Connection>& c, int connId, const string& line) {
+            istringstream in(line);
+            string replyId, command;
+            in >> command;
+            if (!command.empty() && isdigit((unsigned char)command[0])) {
+                replyId = command;
+                in >> command;
+            }
+            vector<string> args;
+            for (string a; in >> a; ) args.push_back(a);
+            Session& s = c->session;
+            auto ok = [&](const string& text) { Send(*c, Reply(replyId, true, text)); };
+            auto fail = [&](const string& text) { Send(*c, Reply(replyId, false, text)); };
+
+            if (command == "protocol_version") ok("2");
+            else if (command == "name") ok("Othello");
+            else if (command == "version") ok("1.0");
+            else if (command == "known_command") {
+                bool known = false;
+                for (const char* k : COMMANDS) known |= !args.empty() && args[0] == k;
+                ok(known ? "true" : "false");
+            } else if (command == "list_commands") {
+                string list;
+                for (const char* k : COMMANDS) list += string(list.empty() ? "" : "\n") + k;
+                ok(list);
+            } else if (command == "quit") {
+                ok("");
+                return false;
+            } else if (command == "boardsize") {
+                if (args.size() == 1 && atoi(args[0].c_str()) == BOARD_SIZE) ok("");
+                else fail("unacceptable size");
+            } else if (command == "clear_board") {
+                s.pos = Position();
+                s.history.clear();
+                s.ResetClock();
+                s.engine->NewGame();
+                ok("");
+            } else if (command == "komi") {
+                ok("");
+            } else if (command == "set_board") {
+                Position pos;
+                string board;
+                for (const string& a : args) board += a;
+                if (!ParseBoard(board, pos)) fail("bad board");
+                else {           // A new game from this position
+                    s.pos = pos;
+                    s.history.clear();
+                    s.ResetClock();
+                    NewEngine(s);
+                    ok("");
+                }
+            } else if (command == "play") {
+                Cell color;
+                if (args.size() != 2 || !ParseColor(args[0], color)) fail("syntax error");
+                else {
+                    string error = PlayMove(s, color, args[1]);
+                    if (error.empty()) ok("");
+                    else fail(error);
+                }
+            } else if (command == "genmove") {
+                Cell color;
+                if (args.size() != 1 || !ParseColor(args[0], color)) fail("syntax error");
+                else GenMove(c, connId, replyId, color);
+            } else if (command == "undo") {
+                if (s.history.empty()) fail("cannot undo");
+                else {
+                    s.pos = s.history.back();
+                    s.history.pop_back();
+                    ok("");
+                }
+            } else if (command == "showboard") {
+                ok(ShowBoard(s.pos));
+            } else if (command == "final_score") {
+                int diff = PopCount(s.pos.bits.black) - PopCount(s.pos.bits.white);
+                ok(diff > 0 ? "B+" + to_string(diff) : diff < 0 ? "W+" + to_string(-diff) : "0");
+            } else if (command == "time_settings") {
+                if (args.size() != 3) fail("syntax error");
+                else {
+                    s.mainTime = atof(args[0].c_str());
+                    s.byoYomi = atof(args[1].c_str());
+                    s.byoStones = atoi(args[2].c_str());
+                    s.ResetClock();
+                    ok("");
+                }
+            } else if (command == "time_left") {
+                Cell color;
+                if (args.size() != 3 || !ParseColor(args[0], color)) fail("syntax error");
+                else {
+                    // Only our own clock matters; we are whoever genmove is asked for
+                    if (color == s.pos.currentPlayer || !s.clock) {
+                        s.clock = true;
+                        s.timeLeft = atof(args[1].c_str());
+                        s.stones = atoi(args[2].c_str());
+                    }
+                    ok("");
+                }
+            } else if (command == "set_time") {
+                if (args.size() != 1 || atof(args[0].c_str()) <= 0) fail("syntax error");
+                else {
+                    s.moveTime = atof(args[0].c_str());
+                    s.clock = false;
+                    ok("");
+                }
+            } else if (command == "set_depth") {
+                if (args.size() != 1 || atoi(args[0].c_str()) <= 0) fail("syntax error");
+                else {
+                    s.maxDepth = min(atoi(args[0].c_str()), (int)MAX_PLY);
+                    NewEngine(s);
+                    ok("");
+                }
+            } else {
+                fail("unknown command");
+            }
+            return true;
+        }
+
+        // Run the waiting lines of a connection until one starts a search
+        void Drain(const shared_ptr<Connection>& c, int connId) {
+            while (!c->busy && !c->closed && !c->lines.empty()) {
+                string line = c->lines.front();
+                c->lines.pop_front();
+                if (!Execute(c, connId, line)) c->closed = true;
+            }
+        }
+
+        void AddConnection(int inFd, int outFd, bool isSocket) {
+            shared_ptr<Connection> c(new Connection());
+            c->inFd = inFd;
+            c->outFd = outFd;
+            c->isSocket = isSocket;
+            c->session.moveTime = settings.thinkTime;
+            c->session.maxDepth = settings.maxDepth;
+            NewEngine(c->session);
+            connections[nextId++] = c;
+        }
+
+        // Split what was read into command lines (GTP: drop comments and blank lines)
+        void ReadInput(const shared_ptr<Connection>& c, int connId) {
+            char buf[4096];
+            ssize_t n = read(c->inFd, buf, sizeof buf);
+            if (n < 0 && (errno == EINTR || errno == EAGAIN)) return;
+            if (n <= 0) {
+                c->inputDone = true;
+                return;
+            }
+            c->input.append(buf, (size_t)n);
+            size_t nl;
+            while ((nl = c->input.find('\n')) != string::npos) {
+                string line = c->input.substr(0, nl);
+                c->input.erase(0, nl + 1);
+                size_t hash = line.find('#');
+                if (hash != string::npos) line.erase(hash);
+                for (char& ch : line)
+                    if (ch == '\t' || ch == '\r') ch = ' ';
+                if (line.find_first_not_of(' ') == string::npos) continue;
+                c->lines.push_back(line);
+            }
+            Drain(c, connId);
+        }
+
+    public:
+        Server(const AISettings& settings, size_t ttSizeMB, int jobs)
+            : settings(settings), tt(ttSizeMB), pool(jobs) {
+            this->settings.sharedTT = &tt;
+            this->settings.threads = 1;     // Parallelism comes from running sessions side by side
+            int fds[2];
+            if (pipe(fds) != 0) throw runtime_error("pipe failed");
+            wakeRead = fds[0];
+            wakeWrite = fds[1];
+            fcntl(wakeRead, F_SETFL, O_NONBLOCK);
+            fcntl(wakeWrite, F_SETFL, O_NONBLOCK);
+        }
+
+        ~Server() {
+            pool.Wait();    // Searches still hold their connections
+            if (listenFd >= 0) close(listenFd);
+            close(wakeRead);
+            close(wakeWrite);
+        }
+
+        void ServeStdin() {
+            AddConnection(STDIN_FILENO, STDOUT_FILENO, false);
+        }
+
+        void Listen(const string& path) {
+            listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (listenFd < 0) throw runtime_error("socket failed");
+            sockaddr_un addr;
+            memset(&addr, 0, sizeof addr);
+            addr.sun_family = AF_UNIX;
+            if (path.size() >= sizeof addr.sun_path) throw runtime_error("Socket path too long");
+            strcpy(addr.sun_path, path.c_str());
+            unlink(path.c_str());
+            if (bind(listenFd, (sockaddr*)&addr, sizeof addr) != 0 || listen(listenFd, 128) != 0)
+                throw runtime_error("Cannot listen on " + path + ": " + strerror(errno));
+            fcntl(listenFd, F_SETFL, O_NONBLOCK);
+        }
+
+        // Serve until stdin is closed and there is no socket to serve
+        void Run() {
+            auto lastAging = Clock::now();
+            while (listenFd >= 0 || !connections.empty()) {
+                vector<pollfd> fds;
+                vector<int> ids;
+                fds.push_back({wakeRead, POLLIN, 0});
+                if (listenFd >= 0) fds.push_back({listenFd, POLLIN, 0});
+                size_t first = fds.size();
+                for (auto& entry : connections) {
+                    if (entry.second->closed || entry.second->inputDone) continue;
+                    fds.push_back({entry.second->inFd, POLLIN, 0});
+                    ids.push_back(entry.first);
+                }
+                if (poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) throw runtime_error("poll failed");
+
+                // Age the shared table about once a second rather than per search, so
+                // one session's searches do not make every other session's entries stale
+                if (Clock::now() - lastAging >= chrono::seconds(1)) {
+                    tt.NewSearch();
+                    lastAging = Clock::now();
+                }
+
+                if (fds[0].revents & POLLIN) {
+                    char buf[256];
+                    while (read(wakeRead, buf, sizeof buf) > 0) {}
+                    vector<Completion> done;
+                    {
+                        lock_guard<mutex> lock(completedMutex);
+                        done.swap(completed);
+                    }
+                    for (const Completion& d : done) {
+                        auto it = connections.find(d.id);
+                        if (it == connections.end()) continue;
+                        shared_ptr<Connection> c = it->second;
+                        c->busy = false;
+                        if (!c->closed) Send(*c, d.reply);
+                        Drain(c, d.id);
+                    }
+                }
+                if (listenFd >= 0 && (fds[1].revents & POLLIN)) {
+                    int fd;
+                    while ((fd = accept(listenFd, nullptr, nullptr)) >= 0) AddConnection(fd, fd, true);
+                }
+                for (size_t i = first; i < fds.size(); i++) {
+                    if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                    int id = ids[i - first];
+                    shared_ptr<Connection> c = connections[id];
+                    ReadInput(c, id);
+                }
+
+                // Drop closed connections once their search is done
+                for (auto it = connections.begin(); it != connections.end(); ) {
+                    Connection& c = *it->second;
+                    if ((c.closed || (c.inputDone && c.lines.empty())) && !c.busy) {
+                        if (c.isSocket) close(c.inFd);
+                        it = connections.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+        }
+};
+
+static void Usage() {
+    cerr << "usage: server [--socket PATH] [--no-stdin] [--jobs N] [--tt MB] [--time SECONDS]\n"
+            "              [--depth N] [--solve EMPTIES] [--weights FILE] [--book FILE]\n";
+}
+
+int main(int argc, char** argv) {
+    string socketPath;
+    bool useStdin = true;
+    int jobs = 0;
+    size_t ttSizeMB = 256;
+    AISettings settings;
+    settings.thinkTime = 1.0;
+    unique_ptr<EvalWeights> weights;
+    unique_ptr<OpeningBook> book;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--socket" && hasValue) socketPath = argv[++i];
+            else if (arg == "--no-stdin") useStdin = false;
+            else if (arg == "--jobs" && hasValue) jobs = atoi(argv[++i]);
+            else if (arg == "--tt" && hasValue) ttSizeMB = (size_t)atoi(argv[++i]);
+            else if (arg == "--time" && hasValue) settings.thinkTime = atof(argv[++i]);
+            else if (arg == "--depth" && hasValue) settings.maxDepth = atoi(argv[++i]);
+            else if (arg == "--solve" && hasValue) settings.solveEmpties = atoi(argv[++i]);
+            else if (arg == "--weights" && hasValue) weights.reset(new EvalWeights(EvalWeights::Load(argv[++i])));
+            else if (arg == "--book" && hasValue) book.reset(new OpeningBook(argv[++i]));
+            else { Usage(); return 1; }
+        }
+        if (!useStdin && socketPath.empty()) throw runtime_error("--no-stdin needs --socket");
+        settings.weights = weights.get();
+        settings.book = book.get();
+        signal(SIGPIPE, SIG_IGN);
+
+        Server server(settings, ttSizeMB, jobs);
+        if (!socketPath.empty()) {
+            server.Listen(socketPath);
+            cerr << "Listening on " << socketPath << "\n";
+        }
+        if (useStdin) server.ServeStdin();
+        server.Run();
+        if (!socketPath.empty()) unlink(socketPath.c_str());
+    } catch (const exception& e) {
+        cerr << "server: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,244 @@
+// Offline evaluation tuner
+//
+// Fits the pattern and feature weights of the evaluator to the final disc
+// differential of self-play games (see selfplay --record). The training files
+// are memory-mapped and every epoch is one full-batch gradient step computed in
+// parallel over shards of the positions; each pattern entry moves by the mean
+// error of the positions that use it, so rare configurations are not starved.
+//
+//   train [--epochs N] [--threads N] [--rate X] [--validation FRACTION]
+//         [--init WEIGHTS] [--out WEIGHTS] FILE...
+//
+// The result is a weight file the GUI loads at startup (weights.bin) and the
+// tools take with --weights / weights=FILE.
+#include "eval.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+#include "training_data.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace std;
+
+// A shard of one mapped file
+struct Shard {
+    const TrainingRecord* records;
+    size_t count;
+    size_t firstIndex;          // Index of records[0] across all files
+};
+
+// Per-thread sums for one epoch
+struct Gradient {
+    vector<double> patternError;        // Sum of errors per pattern entry
+    vector<uint32_t> patternCount;      // Positions using each entry
+    double featureError[EVAL_PHASES][EVAL_FEATURES] = {};    // Sum of error * feature
+    double featureSquare[EVAL_PHASES][EVAL_FEATURES] = {};   // Sum of feature^2
+    double trainSquare = 0, validationSquare = 0;
+    size_t trainCount = 0, validationCount = 0;
+
+    explicit Gradient(size_t size) : patternError(size, 0), patternCount(size, 0) {}
+
+    void Clear() {
+        fill(patternError.begin(), patternError.end(), 0.0);
+        fill(patternCount.begin(), patternCount.end(), 0);
+        for (auto& phase : featureError) for (double& v : phase) v = 0;
+        for (auto& phase : featureSquare) for (double& v : phase) v = 0;
+        trainSquare = validationSquare = 0;
+        trainCount = validationCount = 0;
+    }
+};
+
+// Floating-point master copy of the weights, rounded to EvalWeights on save
+struct Model {
+    size_t phaseSize;
+    vector<float> patterns;
+    float features[EVAL_PHASES][EVAL_FEATURES];
+
+    explicit Model(const EvalWeights& w) : phaseSize(w.phaseSize), patterns(w.patterns.begin(), w.patterns.end()) {
+        for (int p = 0; p < EVAL_PHASES; p++)
+            for (int f = 0; f < EVAL_FEATURES; f++) features[p][f] = w.features[p][f];
+    }
+
+    EvalWeights Quantize() const {
+        EvalWeights w;
+        for (size_t i = 0; i < patterns.size(); i++)
+            w.patterns[i] = (int16_t)max(-32767.0f, min(32767.0f, round(patterns[i])));
+        for (int p = 0; p < EVAL_PHASES; p++)
+            for (int f = 0; f < EVAL_FEATURES; f++)
+                w.features[p][f] = (int16_t)max(-32767.0f, min(32767.0f, round(features[p][f])));
+        // The padding entries must stay zero
+        const PatternSet& set = PatternSet::Get();
+        for (int p = 0; p < EVAL_PHASES; p++)
+            for (size_t i = set.zeroIndex; i < phaseSize; i++) w.Phase(p)[i] = 0;
+        return w;
+    }
+};
+
+// Deterministic split: about `fraction` of the positions are held out
+static bool IsValidation(size_t index, double fraction) {
+    uint64_t h = (index + 1) * 0x9E3779B97F4A7C15ULL;
+    return (double)(h >> 11) / (double)(1ULL << 53) < fraction;
+}
+
+static void Accumulate(const Shard& shard, const Model& model, double validation, Gradient& g) {
+    const PatternSet& set = PatternSet::Get();
+    Evaluator eval;
+    for (size_t i = 0; i < shard.count; i++) {
+        const TrainingRecord& r = shard.records[i];
+        Position pos;
+        pos.bits.black = r.black;
+        pos.bits.white = r.white;
+        pos.currentPlayer = (Cell)r.side;
+        eval.Init(pos);
+        int features[EVAL_FEATURES];
+        Evaluator::Features(pos, features);
+
+        int phase = EvalPhase(PopCount(pos.bits.Empty()));
+        size_t base = phase * model.phaseSize;
+        uint32_t index[EVAL_PATTERNS];
+        double predicted = 0;
+        for (int n = 0; n < EVAL_PATTERNS; n++) {
+            index[n] = (uint32_t)(base + set.slotOffset[n] + eval.Code(n));
+            predicted += model.patterns[index[n]];
+        }
+        for (int f = 0; f < EVAL_FEATURES; f++) predicted += model.features[phase][f] * features[f];
+
+        double error = r.score * EVAL_DISC - predicted;
+        if (IsValidation(shard.firstIndex + i, validation)) {
+            g.validationSquare += error * error;
+            g.validationCount++;
+            continue;
+        }
+        g.trainSquare += error * error;
+        g.trainCount++;
+        for (int n = 0; n < EVAL_PATTERNS; n++) {
+            g.patternError[index[n]] += error;
+            g.patternCount[index[n]]++;
+        }
+        for (int f = 0; f < EVAL_FEATURES; f++) {
+            g.featureError[phase][f] += error * features[f];
+            g.featureSquare[phase][f] += (double)features[f] * features[f];
+        }
+    }
+}
+
+static void Usage() {
+    cerr << "usage: train [--epochs N] [--threads N] [--rate X] [--validation FRACTION]\n"
+            "             [--init WEIGHTS] [--out WEIGHTS] FILE...\n";
+}
+
+int main(int argc, char** argv) {
+    int epochs = 100;
+    int threads = 0;
+    double rate = 1.0;          // Fraction of the mean error corrected per epoch
+    double validation = 0.1;
+    string initFile, outFile = "weights.bin";
+    vector<string> inputs;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--epochs" && hasValue) epochs = atoi(argv[++i]);
+            else if (arg == "--threads" && hasValue) threads = atoi(argv[++i]);
+            else if (arg == "--rate" && hasValue) rate = atof(argv[++i]);
+            else if (arg == "--validation" && hasValue) validation = atof(argv[++i]);
+            else if (arg == "--init" && hasValue) initFile = argv[++i];
+            else if (arg == "--out" && hasValue) outFile = argv[++i];
+            else if (arg.size() > 1 && arg[0] == '-') { Usage(); return 1; }
+            else inputs.push_back(arg);
+        }
+        if (inputs.empty()) { Usage(); return 1; }
+
+        ThreadPool pool(threads);
+        vector<unique_ptr<MappedFile>> files;
+        vector<Shard> shards;
+        size_t total = 0;
+        for (const string& path : inputs) {
+            files.emplace_back(new MappedFile());
+            files.back()->Open(path, true);
+            size_t count;
+            const TrainingRecord* records = TrainingRecords(files.back()->Data(), files.back()->Size(), count);
+            // A few shards per thread so uneven files still balance
+            size_t shardSize = max<size_t>(4096, count / (4 * pool.Size()) + 1);
+            for (size_t first = 0; first < count; first += shardSize)
+                shards.push_back({records + first, min(shardSize, count - first), total + first});
+            total += count;
+        }
+        if (total == 0) throw runtime_error("No training positions");
+
+        Model model(initFile.empty() ? EvalWeights::Default() : EvalWeights::Load(initFile));
+        size_t tableSize = model.patterns.size();
+        vector<unique_ptr<Gradient>> gradients;
+        for (int t = 0; t < pool.Size(); t++) gradients.emplace_back(new Gradient(tableSize));
+
+        cerr << "Training on " << total << " positions from " << inputs.size() << " file(s), "
+             << pool.Size() << " threads\n";
+
+        for (int epoch = 1; epoch <= epochs; epoch++) {
+            auto start = chrono::steady_clock::now();
+
+            // Shards go round-robin to the per-thread sums, one task per sum
+            for (int t = 0; t < pool.Size(); t++) {
+                pool.Submit([&, t]() {
+                    Gradient& g = *gradients[t];
+                    g.Clear();
+                    for (size_t s = t; s < shards.size(); s += pool.Size()) Accumulate(shards[s], model, validation, g);
+                });
+            }
+            pool.Wait();
+
+            // Reduce into the first thread's sums
+            Gradient& sum = *gradients[0];
+            for (size_t t = 1; t < gradients.size(); t++) {
+                const Gradient& g = *gradients[t];
+                for (size_t i = 0; i < tableSize; i++) {
+                    sum.patternError[i] += g.patternError[i];
+                    sum.patternCount[i] += g.patternCount[i];
+                }
+                for (int p = 0; p < EVAL_PHASES; p++)
+                    for (int f = 0; f < EVAL_FEATURES; f++) {
+                        sum.featureError[p][f] += g.featureError[p][f];
+                        sum.featureSquare[p][f] += g.featureSquare[p][f];
+                    }
+                sum.trainSquare += g.trainSquare;
+                sum.validationSquare += g.validationSquare;
+                sum.trainCount += g.trainCount;
+                sum.validationCount += g.validationCount;
+            }
+
+            // A prediction sums EVAL_PATTERNS entries and EVAL_FEATURES terms, so each
+            // term corrects its share of the mean error of the positions that use it;
+            // the +8 damps entries seen only a handful of times
+            const int terms = EVAL_PATTERNS + EVAL_FEATURES;
+            for (size_t i = 0; i < tableSize; i++) {
+                if (sum.patternCount[i] == 0) continue;
+                model.patterns[i] += (float)(rate * sum.patternError[i] / (sum.patternCount[i] + 8.0) / terms);
+            }
+            for (int p = 0; p < EVAL_PHASES; p++)
+                for (int f = 0; f < EVAL_FEATURES; f++)
+                    if (sum.featureSquare[p][f] > 0)
+                        model.features[p][f] += (float)(rate * sum.featureError[p][f] / sum.featureSquare[p][f] / terms);
+
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            double trainRms = sum.trainCount ? sqrt(sum.trainSquare / sum.trainCount) / EVAL_DISC : 0;
+            double validationRms = sum.validationCount ? sqrt(sum.validationSquare / sum.validationCount) / EVAL_DISC : 0;
+            printf("epoch %3d  train rms %6.2f discs  validation rms %6.2f discs  %6.2f s  %5.2f M positions/s\n",
+                   epoch, trainRms, validationRms, seconds, total / seconds / 1e6);
+            fflush(stdout);
+        }
+
+        model.Quantize().Save(outFile);
+        cerr << "Weights written to " << outFile << "\n";
+    } catch (const exception& e) {
+        cerr << "train: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
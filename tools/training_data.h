@@ -0,0 +1,79 @@
+// Training positions for the evaluation tuner - written by selfplay, read by train
+#ifndef OTHELLO_TRAINING_DATA_H
+#define OTHELLO_TRAINING_DATA_H
+
+#include "position.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+// File layout: 16-byte header (magic, record size), then fixed-size records
+const char TRAINING_MAGIC[8] = {'O', 'T', 'H', 'T', 'R', 'N', '0', '1'};
+
+struct TrainingHeader {
+    char magic[8];
+    uint32_t recordSize;
+    uint32_t reserved;
+};
+
+// One position and the final disc differential of its game, both from Black's
+// point of view. Positions with few enough empties for both engines to have
+// solved them carry their exact score.
+struct TrainingRecord {
+    uint64_t black;
+    uint64_t white;
+    int8_t score;           // Final black discs - white discs
+    uint8_t side;           // Cell of the side to move
+    uint8_t reserved[6];
+};
+static_assert(sizeof(TrainingRecord) == 24, "TrainingRecord must stay 24 bytes");
+
+// Appends records to a training file, writing the header if the file is new
+class TrainingWriter {
+    private:
+        std::ofstream out;
+
+    public:
+        explicit TrainingWriter(const std::string& path) {
+            std::ifstream existing(path, std::ios::binary | std::ios::ate);
+            bool empty = !existing || existing.tellg() == 0;
+            out.open(path, std::ios::binary | std::ios::app);
+            if (!out) throw std::runtime_error("Failed to open " + path + " for writing");
+            if (empty) {
+                TrainingHeader header;
+                std::memcpy(header.magic, TRAINING_MAGIC, sizeof header.magic);
+                header.recordSize = sizeof(TrainingRecord);
+                header.reserved = 0;
+                out.write(reinterpret_cast<const char*>(&header), sizeof header);
+            }
+        }
+
+        void Append(const Position& pos, int finalScore) {
+            TrainingRecord r;
+            std::memset(&r, 0, sizeof r);
+            r.black = pos.bits.black;
+            r.white = pos.bits.white;
+            r.score = (int8_t)finalScore;
+            r.side = (uint8_t)pos.currentPlayer;
+            out.write(reinterpret_cast<const char*>(&r), sizeof r);
+        }
+
+        void Flush() {
+            out.flush();
+        }
+};
+
+// Records of a mapped training file; throws if the header does not match
+inline const TrainingRecord* TrainingRecords(const unsigned char* data, size_t size, size_t& count) {
+    TrainingHeader header;
+    if (size < sizeof header) throw std::runtime_error("Training file too short");
+    std::memcpy(&header, data, sizeof header);
+    if (std::memcmp(header.magic, TRAINING_MAGIC, sizeof header.magic) != 0 || header.recordSize != sizeof(TrainingRecord))
+        throw std::runtime_error("Not a training file (bad header)");
+    count = (size - sizeof header) / sizeof(TrainingRecord);
+    return reinterpret_cast<const TrainingRecord*>(data + sizeof header);
+}
+
+#endif